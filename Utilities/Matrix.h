@@ -13,6 +13,11 @@
 
 #include<string>
 #include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<new>
+#include<type_traits>
+#include<utility>
 //#include<iostream>
 
 namespace Numeric_lib {
@@ -36,10 +41,64 @@ inline void error(const char* p)
 
 typedef long Index;    // I still dislike unsigned
 
+inline bool out_of_range(Index n, Index d)
+    // n<0 || d<=n in one comparison (a dimension is never negative)
+{
+    return static_cast<unsigned long>(n)>=static_cast<unsigned long>(d);
+}
+
+//-----------------------------------------------------------------------------
+
+// The default allocator for the elements of a Matrix: every block starts on a
+// 64-byte boundary, so a Matrix starts on a cache line and vector loads from it
+// are never split across two lines.
+// Any allocator with allocate(n), deallocate(p,n), == and a copy constructor
+// will do instead (a pool, a per-job arena, huge pages); Matrix_base constructs
+// the elements itself, so the allocator only provides memory.
+template<class T> struct Aligned_allocator {
+    typedef T value_type;
+    static const std::size_t alignment = 64;
+    static_assert(alignof(T)<=alignment, "element type needs more than 64-byte alignment");
+
+    template<class U> struct rebind { typedef Aligned_allocator<U> other; };
+
+    Aligned_allocator() { }
+    template<class U> Aligned_allocator(const Aligned_allocator<U>&) { }
+
+    T* allocate(std::size_t n)
+        // over-allocate by one alignment, and keep the start of the block just
+        // below the aligned address (new gives at least pointer alignment, so there is room)
+    {
+        if (n>(std::size_t(-1)-alignment)/sizeof(T)) throw std::bad_alloc();
+        char* raw = static_cast<char*>(::operator new(n*sizeof(T)+alignment));
+        char* p = raw+alignment-reinterpret_cast<std::uintptr_t>(raw)%alignment;
+        reinterpret_cast<void**>(p)[-1] = raw;
+        return reinterpret_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+        if (p) ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+};
+
+template<class T, class U> bool operator==(const Aligned_allocator<T>&, const Aligned_allocator<U>&) { return true; }
+template<class T, class U> bool operator!=(const Aligned_allocator<T>&, const Aligned_allocator<U>&) { return false; }
+
+//-----------------------------------------------------------------------------
+
+struct No_init { };    // Matrix(n,No_init()) leaves numbers uninitialized, for a Matrix about to be overwritten
+
+// the allocator a Matrix with allocator type A takes from an operand's allocator b:
+// a copy of b if b is an A, a default A otherwise
+template<class A, class B> struct Allocator_from { static A get(const B&) { return A(); } };
+template<class A> struct Allocator_from<A,A> { static const A& get(const A& b) { return b; } };
+template<class A, class B> A allocator_from(const B& b) { return Allocator_from<A,B>::get(b); }
+
 //-----------------------------------------------------------------------------
 
 // The general Matrix template is simply a prop for its specializations:
-template<class T = double, int D = 1> class Matrix {
+template<class T = double, int D = 1, class A = Aligned_allocator<T> > class Matrix {
     // multidimensional matrix class
     // ( ) does multidimensional subscripting
     // [ ] does C style "slicing": gives an N-1 dimensional matrix from an N dimensional one
@@ -48,13 +107,22 @@ template<class T = double, int D = 1> class Matrix {
     // = has copy semantics
     // ( ) and [ ] are range checked
     // slice() to give sub-ranges 
+    // at_unchecked() is ( ) without the range check, for inner loops whose bounds are known
+    // begin() and end() are raw pointers over all the elements; row_begin() and row_end() over one row
+    // A allocates the elements; a Matrix built with an allocator object keeps a copy of it
 private:
     Matrix();    // this should never be compiled
 };
 
 //-----------------------------------------------------------------------------
 
-template<class T = double, int D = 1> class Row ;    // forward declaration
+template<class T = double, int D = 1, class A = Aligned_allocator<T> > class Row ;    // forward declaration
+
+struct Matrix_expr { };    // base of the expression templates at the end of this file
+
+template<class E, class R = void> struct If_expr
+    // R if E is an expression, for overloads that take only expressions
+    : std::enable_if<std::is_base_of<Matrix_expr,E>::value,R> { };
 
 //-----------------------------------------------------------------------------
 
@@ -107,32 +175,179 @@ template<class T> struct Complement {
 
 //-----------------------------------------------------------------------------
 
+// explicitly vectorized forms of the built-in functors for base_apply(f,c):
+// the functor is mapped to an operation code, and the loop is written with
+// GCC vector types, 16 bytes at a time with SSE2 or 32 bytes at a time with
+// AVX2 if the processor has it (checked once, at run time).
+// The results are those of the plain loop: the integer operations wrap,
+// as the small types do when a += c is converted back, and the floating
+// point operations are the same IEEE operations element by element.
+// Other compilers and processors, unoptimized builds, other functors,
+// and / and % use the plain loop.
+
+enum Simd_code { simd_none, simd_assign, simd_add, simd_minus, simd_mul, simd_and, simd_or, simd_xor };
+
+template<class F> struct Simd_op                   { static const int code = simd_none; };
+template<class T> struct Simd_op< Assign<T> >       { static const int code = simd_assign; };
+template<class T> struct Simd_op< Add_assign<T> >   { static const int code = simd_add; };
+template<class T> struct Simd_op< Minus_assign<T> > { static const int code = simd_minus; };
+template<class T> struct Simd_op< Mul_assign<T> >   { static const int code = simd_mul; };
+template<class T> struct Simd_op< And_assign<T> >   { static const int code = simd_and; };
+template<class T> struct Simd_op< Or_assign<T> >    { static const int code = simd_or; };
+template<class T> struct Simd_op< Xor_assign<T> >   { static const int code = simd_xor; };
+
+template<class T> struct Simd_type {
+    // the element types GCC has vectors of
+    static const bool ok = std::is_arithmetic<T>::value
+                        && !std::is_same<T,bool>::value
+                        && !std::is_same<T,long double>::value;
+};
+
+template<class T, int OP, bool OK = (OP!=simd_none && Simd_type<T>::ok)> struct Simd_apply {
+    static bool apply(T*, Index, const T&) { return false; }    // use the plain loop
+};
+
+#if defined(__GNUC__) && defined(__OPTIMIZE__) && (defined(__x86_64__) || defined(__i386__))
+
+// the operations, on a vector or on a single element for the tail;
+// vectors are passed by reference so that no 32-byte vector crosses a call
+template<int OP> struct Simd_kernel;
+template<> struct Simd_kernel<simd_assign> { template<class V, class C> static void run(V& a, const C& c) { a = c; } };
+template<> struct Simd_kernel<simd_add>    { template<class V, class C> static void run(V& a, const C& c) { a += c; } };
+template<> struct Simd_kernel<simd_minus>  { template<class V, class C> static void run(V& a, const C& c) { a -= c; } };
+template<> struct Simd_kernel<simd_mul>    { template<class V, class C> static void run(V& a, const C& c) { a *= c; } };
+template<> struct Simd_kernel<simd_and>    { template<class V, class C> static void run(V& a, const C& c) { a &= c; } };
+template<> struct Simd_kernel<simd_or>     { template<class V, class C> static void run(V& a, const C& c) { a |= c; } };
+template<> struct Simd_kernel<simd_xor>    { template<class V, class C> static void run(V& a, const C& c) { a ^= c; } };
+
+// signed integers are added and multiplied as unsigned ones, which wrap without
+// undefined behavior and give the same bits; a single element is worked on as at
+// least an unsigned int, since a smaller type would be promoted to (signed) int
+template<class T, bool = std::is_integral<T>::value> struct Simd_lane { typedef T type; typedef T scalar; };
+template<class T> struct Simd_lane<T,true> {
+    typedef typename std::make_unsigned<T>::type type;
+    typedef typename std::common_type<type,unsigned>::type scalar;
+};
+
+template<class T, int OP, int BYTES> inline __attribute__((always_inline))
+Index simd_loop(T* p, Index n, const T& c, Index i)
+    // the whole vectors of p[i..n), returning where the tail starts;
+    // memcpy is how to load and store unaligned without breaking aliasing
+{
+    typedef typename Simd_lane<T>::type U;
+    typedef U V __attribute__((vector_size(BYTES)));
+    const Index lanes = BYTES/sizeof(T);
+    V cv;
+    for (Index k = 0; k<lanes; ++k) cv[k] = static_cast<U>(c);
+    for (; i+lanes<=n; i+=lanes) {
+        V v;
+        std::memcpy(&v,p+i,sizeof(V));
+        Simd_kernel<OP>::run(v,cv);
+        std::memcpy(p+i,&v,sizeof(V));
+    }
+    return i;
+}
+
+template<class T, int OP> __attribute__((target("avx2")))
+Index simd_loop_avx2(T* p, Index n, const T& c, Index i)
+{
+    return simd_loop<T,OP,32>(p,n,c,i);
+}
+
+inline bool simd_has_avx2()
+{
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+}
+
+template<class T, int OP> struct Simd_apply<T,OP,true> {
+    static bool apply(T* p, Index n, const T& c)
+    {
+        Index i = simd_has_avx2() ? simd_loop_avx2<T,OP>(p,n,c,0) : simd_loop<T,OP,16>(p,n,c,0);
+        typedef typename Simd_lane<T>::scalar S;
+        for (; i<n; ++i) {
+            S x = static_cast<S>(p[i]);
+            Simd_kernel<OP>::run(x,static_cast<S>(c));
+            p[i] = static_cast<T>(x);
+        }
+        return true;
+    }
+};
+
+#endif
+
+//-----------------------------------------------------------------------------
+
 // Matrix_base represents the common part of the Matrix classes:
-template<class T> class Matrix_base {
-    // matrixs store their memory (elements) in Matrix_base and have copy semantics
+template<class T, class A = Aligned_allocator<T> > class Matrix_base {
+    // matrixs store their memory (elements) in Matrix_base and have copy and move semantics
     // Matrix_base does element-wise operations
 protected:
     T* elem;    // vector? no: we couldn't easily provide a vector for a slice
-    const Index sz;    
-    mutable bool owns;
-    mutable bool xfer;
+    Index sz;    // not const: a Matrix that owns its elements may be given new ones
+    bool owns;
+    A alloc;    // gives (and takes back) the elements of a Matrix that owns them
+
+    T* allocate(Index n, bool init)
+        // n elements from alloc: value initialized (zero for numbers) if init,
+        // default initialized (left alone for numbers) if not
+    {
+        T* p = alloc.allocate(n);
+        Index i = 0;
+        try {
+            if (init) for (; i<n; ++i) new(p+i) T();
+            else      for (; i<n; ++i) new(p+i) T;
+        }
+        catch (...) {
+            release(p,i);
+            throw;
+        }
+        return p;
+    }
+
+    void release(T* p, Index n)
+    {
+        for (Index i = 0; i<n; ++i) p[i].~T();
+        alloc.deallocate(p,n);
+    }
 public:
-    Matrix_base(Index n) :elem(new T[n]()), sz(n), owns(true), xfer(false)
+    typedef A allocator_type;
+
+    Matrix_base(Index n, const A& a = A()) :elem(0), sz(n), owns(true), alloc(a)
         // matrix of n elements (default initialized)
     {
+        elem = allocate(n,true);
         // std::cerr << "new[" << n << "]->" << elem << "\n";
     }
 
-    Matrix_base(Index n, T* p) :elem(p), sz(n), owns(false), xfer(false)
+    Matrix_base(Index n, No_init, const A& a = A()) :elem(0), sz(n), owns(true), alloc(a)
+        // matrix of n elements that the caller will overwrite
+    {
+        elem = allocate(n,false);
+    }
+
+    Matrix_base(Index n, T* p, const A& a = A()) :elem(p), sz(n), owns(false), alloc(a)
         // descriptor for matrix of n elements owned by someone else
     {
     }
 
+    Matrix_base(Matrix_base&& a) noexcept :elem(a.elem), sz(a.sz), owns(a.owns), alloc(a.alloc)
+        // take a's elements, leaving a as an empty Matrix that can be assigned any shape.
+        // Never allocates: if a owns no elements (a Row, or a mapped file) the result is
+        // another descriptor for the same ones and a is left alone. Row to Matrix copies
+        // go through the Matrix(Row&&) constructors, and xfer() copies what it does not own
+    {
+        if (!owns) return;
+        a.elem = 0;
+        a.sz = 0;
+        a.owns = true;
+    }
+
     ~Matrix_base()
     {
-        if (owns) {
+        if (owns && elem) {
             // std::cerr << "delete[" << sz << "] " << elem << "\n";
-            delete[]elem;
+            release(elem,sz);
         }
     }
 
@@ -141,43 +356,90 @@ public:
     const T* data() const { return elem; }
     Index    size() const { return sz; }
 
+    // raw-pointer iterators over all the elements in row-major order (not range checked):
+    typedef       T* iterator;
+    typedef const T* const_iterator;
+          T* begin()       { return elem; }
+    const T* begin() const { return elem; }
+          T* end()         { return elem+sz; }
+    const T* end() const   { return elem+sz; }
+    const A& get_allocator() const { return alloc; }
+
     void copy_elements(const Matrix_base& a)
     {
         if (sz!=a.sz) error("copy_elements()");
         for (Index i=0; i<sz; ++i) elem[i] = a.elem[i];
     }
 
-    void base_assign(const Matrix_base& a) { copy_elements(a); }
+    void base_assign(const Matrix_base& a)
+        // a Matrix that owns its elements takes a's size; a Row must already have it.
+        // The new elements are filled before the old ones go, in case a is a Row of this
+    {
+        if (sz==a.sz || !owns) {
+            copy_elements(a);
+            return;
+        }
+        T* p = allocate(a.sz,false);
+        for (Index i=0; i<a.sz; ++i) p[i] = a.elem[i];
+        if (elem) release(elem,sz);
+        elem = p;
+        sz = a.sz;
+    }
 
     void base_copy(const Matrix_base& a)
     {
-        if (a.xfer) {          // a is just about to be deleted
-                               // so we can transfer ownership rather than copy
-            // std::cerr << "xfer @" << a.elem << " [" << a.sz << "]\n";
+        elem = allocate(a.sz,false);
+        owns = true;
+        // std::cerr << "base copy @" << a.elem << " [" << a.sz << "]\n";
+        copy_elements(a);
+    }
+
+    bool base_move(Matrix_base& a)
+        // take a's elements if both own theirs and one allocator can free
+        // what the other gave; otherwise the caller copies
+    {
+        if (!owns || !a.owns || !(alloc==a.alloc)) return false;
+        if (this!=&a) {
+            if (elem) release(elem,sz);
             elem = a.elem;
-            a.xfer = false;    // note: modifies source
-            a.owns = false;
-        }
-        else {
-            elem = new T[a.sz];
-            // std::cerr << "base copy @" << a.elem << " [" << a.sz << "]\n";
-            copy_elements(a);
+            sz = a.sz;
+            a.elem = 0;
+            a.sz = 0;
         }
+        return true;
+    }
+
+    template<class E> void base_eval(const E& e)
+        // allocate and compute the elements in one pass, for a constructor
+    {
+        elem = allocate(sz,false);
         owns = true;
-        xfer = false;
+        for (Index i = 0; i<sz; ++i) elem[i] = e[i];
     }
 
-    // to get the elements of a local matrix out of a function without copying:
-    void base_xfer(Matrix_base& x)
+    template<class E> void base_assign_expr(const E& e)
+        // each element depends only on the same element of each operand,
+        // so the destination may also be an operand (but not a shifted slice of one);
+        // a new size gets new elements, filled before the old ones go
     {
-        if (owns==false) error("cannot xfer() non-owner");
-        owns = false;     // now the elements are safe from deletion by original owner
-        x.xfer = true;    // target asserts temporary ownership
-        x.owns = true;
+        if (sz==e.size() || !owns) {
+            for (Index i = 0; i<sz; ++i) elem[i] = e[i];
+            return;
+        }
+        Index n = e.size();
+        T* p = allocate(n,false);
+        for (Index i = 0; i<n; ++i) p[i] = e[i];
+        if (elem) release(elem,sz);
+        elem = p;
+        sz = n;
     }
 
     template<class F> void base_apply(F f) { for (Index i = 0; i<size(); ++i) f(elem[i]); }
-    template<class F> void base_apply(F f, const T& c) { for (Index i = 0; i<size(); ++i) f(elem[i],c); }
+    template<class F> void base_apply(F f, const T& c)
+    {
+        if (Simd_apply<T,Simd_op<F>::code>::apply(elem,sz,c)) return;    // a built-in functor at SIMD width
+        for (Index i = 0; i<size(); ++i) f(elem[i],c);
+    }
 private:
     void operator=(const Matrix_base&);    // no ordinary copy of bases
     Matrix_base(const Matrix_base&);
@@ -185,48 +447,64 @@ private:
 
 //-----------------------------------------------------------------------------
 
-template<class T> class Matrix<T,1> : public Matrix_base<T> {
-    const Index d1;
+template<class T, class A> class Matrix<T,1,A> : public Matrix_base<T,A> {
+    Index d1;
 
 protected:
     // for use by Row:
-    Matrix(Index n1, T* p) : Matrix_base<T>(n1,p), d1(n1)
+    Matrix(Index n1, T* p, const A& a = A()) : Matrix_base<T,A>(n1,p,a), d1(n1)
     {
         // std::cerr << "construct 1D Matrix from data\n";
     }
 
 public:
 
-    Matrix(Index n1) : Matrix_base<T>(n1), d1(n1) { }
+    Matrix(Index n1, const A& a = A()) : Matrix_base<T,A>(n1,a), d1(n1) { }
+    Matrix(Index n1, No_init, const A& a = A()) : Matrix_base<T,A>(n1,No_init(),a), d1(n1) { }
 
-    Matrix(Row<T,1>& a) : Matrix_base<T>(a.dim1(),a.p), d1(a.dim1()) 
+    Matrix(Row<T,1,A>& a) : Matrix_base<T,A>(a.dim1(),a.p), d1(a.dim1()) 
     { 
         // std::cerr << "construct 1D Matrix from Row\n";
     }
 
+    // a Row given by value (such as m[i]) is copied, so the new Matrix does not share its elements:
+    Matrix(Row<T,1,A>&& a) : Matrix(static_cast<const Matrix&>(a)) { }
+
     // copy constructor: let the base do the copy:
-    Matrix(const Matrix& a) : Matrix_base<T>(a.size(),0), d1(a.d1)
+    Matrix(const Matrix& a) : Matrix_base<T,A>(a.size(),0,a.alloc), d1(a.d1)
     {
         // std::cerr << "copy ctor\n";
         this->base_copy(a);
     }
 
+    // move constructor: take a's elements, so returning a Matrix by value never copies:
+    Matrix(Matrix&& a) noexcept : Matrix_base<T,A>(std::move(a)), d1(a.d1)
+    {
+        if (this->owns) a.d1 = 0;    // a descriptor is left alone
+    }
+
+    // evaluate an expression such as a*c+b in one pass, with no temporaries:
+    template<class E> Matrix(const E& e, typename If_expr<E>::type* = 0) : Matrix_base<T,A>(e.size(),0,allocator_from<A>(e.shape().get_allocator())), d1(e.shape().dim1())
+    {
+        this->base_eval(e);
+    }
+
     template<int n> 
-    Matrix(const T (&a)[n]) : Matrix_base<T>(n), d1(n)
+    Matrix(const T (&a)[n]) : Matrix_base<T,A>(n,No_init()), d1(n)
         // deduce "n" (and "T"), Matrix_base allocates T[n]
     {
         // std::cerr << "matrix ctor\n";
         for (Index i = 0; i<n; ++i) this->elem[i]=a[i];
     }
 
-    Matrix(const T* p, Index n) : Matrix_base<T>(n), d1(n)
+    Matrix(const T* p, Index n) : Matrix_base<T,A>(n,No_init()), d1(n)
         // Matrix_base allocates T[n]
     {
         // std::cerr << "matrix ctor\n";
         for (Index i = 0; i<n; ++i) this->elem[i]=p[i];
     }
 
-    template<class F> Matrix(const Matrix& a, F f) : Matrix_base<T>(a.size()), d1(a.d1)
+    template<class F> Matrix(const Matrix& a, F f) : Matrix_base<T,A>(a.size(),No_init(),a.alloc), d1(a.d1)
         // construct a new Matrix with element's that are functions of a's elements:
         // does not modify a unless f has been specifically programmed to modify its argument
         // T f(const T&) would be a typical type for f
@@ -234,7 +512,7 @@ public:
         for (Index i = 0; i<this->sz; ++i) this->elem[i] = f(a.elem[i]); 
     }
 
-    template<class F, class Arg> Matrix(const Matrix& a, F f, const Arg& t1) : Matrix_base<T>(a.size()), d1(a.d1)
+    template<class F, class Arg> Matrix(const Matrix& a, F f, const Arg& t1) : Matrix_base<T,A>(a.size(),No_init(),a.alloc), d1(a.d1)
         // construct a new Matrix with element's that are functions of a's elements:
         // does not modify a unless f has been specifically programmed to modify its argument
         // T f(const T&, const Arg&) would be a typical type for f
@@ -243,11 +521,34 @@ public:
     }
 
     Matrix& operator=(const Matrix& a)
-        // copy assignment: let the base do the copy
+        // copy assignment: let the base do the copy;
+        // a Matrix that owns its elements takes a's shape, a Row must already have it
     {
         // std::cerr << "copy assignment (" << this->size() << ',' << a.size()<< ")\n";
-        if (d1!=a.d1) error("length error in 1D=");
+        if (!this->owns && (d1!=a.d1)) error("length error in 1D=");
         this->base_assign(a);
+        d1 = a.d1;
+        return *this;
+    }
+
+    Matrix& operator=(Matrix&& a)
+        // move assignment: take a's elements and shape, or copy if either is a Row
+    {
+        if (!this->base_move(a)) return *this = static_cast<const Matrix&>(a);
+        if (this!=&a) {
+            d1 = a.d1;
+            a.d1 = 0;
+        }
+        return *this;
+    }
+
+    template<class E> typename If_expr<E,Matrix&>::type operator=(const E& e)
+        // assignment of an expression writes straight into the elements
+    {
+        if (!this->owns && (d1!=e.shape().dim1())) error("length error in 1D=");
+        Index n1 = e.shape().dim1();
+        this->base_assign_expr(e);
+        d1 = n1;
         return *this;
     }
 
@@ -255,23 +556,27 @@ public:
 
     Index dim1() const { return d1; }    // number of elements in a row
 
-    Matrix xfer()    // make an Matrix to move elements out of a scope
+    Matrix xfer()    // the old way to move elements out of a scope: now the same as std::move(*this),
+                     // except that the elements of a Row (or any Matrix that does not own them) are copied
     {
-        Matrix x(dim1(),this->data()); // make a descriptor
-        this->base_xfer(x);                  // transfer (temporary) ownership to x
-        return x;
+        if (!this->owns) return Matrix(static_cast<const Matrix&>(*this));
+        return std::move(*this);
     }
 
     void range_check(Index n1) const
     {
         // std::cerr << "range check: (" << d1 << "): " << n1 << "\n"; 
-        if (n1<0 || d1<=n1) error("1D range error: dimension 1");
+        if (out_of_range(n1,d1)) error("1D range error: dimension 1");
     }
 
     // subscripting:
           T& operator()(Index n1)       { range_check(n1); return this->elem[n1]; }
     const T& operator()(Index n1) const { range_check(n1); return this->elem[n1]; }
 
+    // subscripting without range checking:
+          T& at_unchecked(Index n1)       { return this->elem[n1]; }
+    const T& at_unchecked(Index n1) const { return this->elem[n1]; }
+
     // slicing (the same as subscripting for 1D matrixs):
           T& operator[](Index n)       { return row(n); }
     const T& operator[](Index n) const { return row(n); }
@@ -279,40 +584,40 @@ public:
           T& row(Index n)       { range_check(n); return this->elem[n]; }
     const T& row(Index n) const { range_check(n); return this->elem[n]; }
 
-    Row<T,1> slice(Index n)
+    Row<T,1,A> slice(Index n)
         // the last elements from a[n] onwards
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;// one beyond the end
-        return Row<T,1>(d1-n,this->elem+n);
+        return Row<T,1,A>(d1-n,this->elem+n,this->alloc);
     }
 
-    const Row<T,1> slice(Index n) const
+    const Row<T,1,A> slice(Index n) const
         // the last elements from a[n] onwards
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;// one beyond the end
-        return Row<T,1>(d1-n,this->elem+n);
+        return Row<T,1,A>(d1-n,this->elem+n,this->alloc);
     }
 
-    Row<T,1> slice(Index n, Index m)
+    Row<T,1,A> slice(Index n, Index m)
         // m elements starting with a[n]
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;    // one beyond the end
         if (m<0) m = 0;
         else if (d1<n+m) m=d1-n;
-        return Row<T,1>(m,this->elem+n);
+        return Row<T,1,A>(m,this->elem+n,this->alloc);
     }
 
-    const Row<T,1> slice(Index n, Index m) const
+    const Row<T,1,A> slice(Index n, Index m) const
         // m elements starting with a[n]
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;    // one beyond the end
         if (m<0) m = 0;
         else if (d1<n+m) m=d1-n;
-        return Row<T,1>(m,this->elem+n);
+        return Row<T,1,A>(m,this->elem+n,this->alloc);
     }
 
     // element-wise operations:
@@ -331,11 +636,11 @@ public:
     Matrix& operator|=(const T& c) { this->base_apply(Or_assign<T>(),c);    return *this; }
     Matrix& operator^=(const T& c) { this->base_apply(Xor_assign<T>(),c);   return *this; }
 
-    Matrix operator!() { return xfer(Matrix(*this,Not<T>())); }
-    Matrix operator-() { return xfer(Matrix(*this,Unary_minus<T>())); }
-    Matrix operator~() { return xfer(Matrix(*this,Complement<T>()));  }
+    Matrix operator!() { return Matrix(*this,Not<T>()); }
+    Matrix operator-() { return Matrix(*this,Unary_minus<T>()); }
+    Matrix operator~() { return Matrix(*this,Complement<T>());  }
 
-    template<class F> Matrix apply_new(F f) { return xfer(Matrix(*this,f)); }
+    template<class F> Matrix apply_new(F f) { return Matrix(*this,f); }
     
     void swap_rows(Index i, Index j)
         // swap_rows() uses a row's worth of memory for better run-time performance
@@ -343,7 +648,7 @@ public:
     {
         if (i == j) return;
     /*
-        Matrix<T,1> temp = (*this)[i];
+        Matrix<T,1,A> temp = (*this)[i];
         (*this)[i] = (*this)[j];
         (*this)[j] = temp;
     */
@@ -354,35 +659,51 @@ public:
 
 //-----------------------------------------------------------------------------
 
-template<class T> class Matrix<T,2> : public Matrix_base<T> {
-    const Index d1;
-    const Index d2;
+template<class T, class A> class Matrix<T,2,A> : public Matrix_base<T,A> {
+    Index d1;
+    Index d2;
 
 protected:
     // for use by Row:
-    Matrix(Index n1, Index n2, T* p) : Matrix_base<T>(n1*n2,p), d1(n1), d2(n2) 
+    Matrix(Index n1, Index n2, T* p, const A& a = A()) : Matrix_base<T,A>(n1*n2,p,a), d1(n1), d2(n2) 
     {
         // std::cerr << "construct 3D Matrix from data\n";
     }
 
 public:
 
-    Matrix(Index n1, Index n2) : Matrix_base<T>(n1*n2), d1(n1), d2(n2) { }
+    Matrix(Index n1, Index n2, const A& a = A()) : Matrix_base<T,A>(n1*n2,a), d1(n1), d2(n2) { }
+    Matrix(Index n1, Index n2, No_init, const A& a = A()) : Matrix_base<T,A>(n1*n2,No_init(),a), d1(n1), d2(n2) { }
 
-    Matrix(Row<T,2>& a) : Matrix_base<T>(a.dim1()*a.dim2(),a.p), d1(a.dim1()), d2(a.dim2())
+    Matrix(Row<T,2,A>& a) : Matrix_base<T,A>(a.dim1()*a.dim2(),a.p), d1(a.dim1()), d2(a.dim2())
     { 
         // std::cerr << "construct 2D Matrix from Row\n";
     }
 
+    // a Row given by value (such as m[i]) is copied, so the new Matrix does not share its elements:
+    Matrix(Row<T,2,A>&& a) : Matrix(static_cast<const Matrix&>(a)) { }
+
     // copy constructor: let the base do the copy:
-    Matrix(const Matrix& a) : Matrix_base<T>(a.size(),0), d1(a.d1), d2(a.d2)
+    Matrix(const Matrix& a) : Matrix_base<T,A>(a.size(),0,a.alloc), d1(a.d1), d2(a.d2)
     {
         // std::cerr << "copy ctor\n";
         this->base_copy(a);
     }
 
+    // move constructor: take a's elements, so returning a Matrix by value never copies:
+    Matrix(Matrix&& a) noexcept : Matrix_base<T,A>(std::move(a)), d1(a.d1), d2(a.d2)
+    {
+        if (this->owns) { a.d1 = 0; a.d2 = 0; }    // a descriptor is left alone
+    }
+
+    // evaluate an expression such as a*c+b in one pass, with no temporaries:
+    template<class E> Matrix(const E& e, typename If_expr<E>::type* = 0) : Matrix_base<T,A>(e.size(),0,allocator_from<A>(e.shape().get_allocator())), d1(e.shape().dim1()), d2(e.shape().dim2())
+    {
+        this->base_eval(e);
+    }
+
     template<int n1, int n2> 
-    Matrix(const T (&a)[n1][n2]) : Matrix_base<T>(n1*n2), d1(n1), d2(n2)
+    Matrix(const T (&a)[n1][n2]) : Matrix_base<T,A>(n1*n2,No_init()), d1(n1), d2(n2)
         // deduce "n1", "n2" (and "T"), Matrix_base allocates T[n1*n2]
     {
         // std::cerr << "matrix ctor\n";
@@ -390,7 +711,7 @@ public:
             for (Index j = 0; j<n2; ++j) this->elem[i*n2+j]=a[i][j];
     }
 
-    template<class F> Matrix(const Matrix& a, F f) : Matrix_base<T>(a.size()), d1(a.d1), d2(a.d2)
+    template<class F> Matrix(const Matrix& a, F f) : Matrix_base<T,A>(a.size(),No_init(),a.alloc), d1(a.d1), d2(a.d2)
         // construct a new Matrix with element's that are functions of a's elements:
         // does not modify a unless f has been specifically programmed to modify its argument
         // T f(const T&) would be a typical type for f
@@ -398,7 +719,7 @@ public:
         for (Index i = 0; i<this->sz; ++i) this->elem[i] = f(a.elem[i]); 
     }
 
-    template<class F, class Arg> Matrix(const Matrix& a, F f, const Arg& t1) : Matrix_base<T>(a.size()), d1(a.d1), d2(a.d2)
+    template<class F, class Arg> Matrix(const Matrix& a, F f, const Arg& t1) : Matrix_base<T,A>(a.size(),No_init(),a.alloc), d1(a.d1), d2(a.d2)
         // construct a new Matrix with element's that are functions of a's elements:
         // does not modify a unless f has been specifically programmed to modify its argument
         // T f(const T&, const Arg&) would be a typical type for f
@@ -407,11 +728,34 @@ public:
     }
 
     Matrix& operator=(const Matrix& a)
-        // copy assignment: let the base do the copy
+        // copy assignment: let the base do the copy;
+        // a Matrix that owns its elements takes a's shape, a Row must already have it
     {
         // std::cerr << "copy assignment (" << this->size() << ',' << a.size()<< ")\n";
-        if (d1!=a.d1 || d2!=a.d2) error("length error in 2D =");
+        if (!this->owns && (d1!=a.d1 || d2!=a.d2)) error("length error in 2D =");
         this->base_assign(a);
+        d1 = a.d1; d2 = a.d2;
+        return *this;
+    }
+
+    Matrix& operator=(Matrix&& a)
+        // move assignment: take a's elements and shape, or copy if either is a Row
+    {
+        if (!this->base_move(a)) return *this = static_cast<const Matrix&>(a);
+        if (this!=&a) {
+            d1 = a.d1; d2 = a.d2;
+            a.d1 = 0; a.d2 = 0;
+        }
+        return *this;
+    }
+
+    template<class E> typename If_expr<E,Matrix&>::type operator=(const E& e)
+        // assignment of an expression writes straight into the elements
+    {
+        if (!this->owns && (d1!=e.shape().dim1() || d2!=e.shape().dim2())) error("length error in 2D =");
+        Index n1 = e.shape().dim1(); Index n2 = e.shape().dim2();
+        this->base_assign_expr(e);
+        d1 = n1; d2 = n2;
         return *this;
     }
 
@@ -420,62 +764,72 @@ public:
     Index dim1() const { return d1; }    // number of elements in a row
     Index dim2() const { return d2; }    // number of elements in a column
 
-    Matrix xfer()    // make an Matrix to move elements out of a scope
+    Matrix xfer()    // the old way to move elements out of a scope: now the same as std::move(*this),
+                     // except that the elements of a Row (or any Matrix that does not own them) are copied
     {
-        Matrix x(dim1(),dim2(),this->data()); // make a descriptor
-        this->base_xfer(x);            // transfer (temporary) ownership to x
-        return x;
+        if (!this->owns) return Matrix(static_cast<const Matrix&>(*this));
+        return std::move(*this);
     }
 
     void range_check(Index n1, Index n2) const
     {
         // std::cerr << "range check: (" << d1 << "," << d2 << "): " << n1 << " " << n2 << "\n";
-        if (n1<0 || d1<=n1) error("2D range error: dimension 1");
-        if (n2<0 || d2<=n2) error("2D range error: dimension 2");
+        if (out_of_range(n1,d1)) error("2D range error: dimension 1");
+        if (out_of_range(n2,d2)) error("2D range error: dimension 2");
     }
 
     // subscripting:
           T& operator()(Index n1, Index n2)       { range_check(n1,n2); return this->elem[n1*d2+n2]; }
     const T& operator()(Index n1, Index n2) const { range_check(n1,n2); return this->elem[n1*d2+n2]; }
 
+    // subscripting without range checking:
+          T& at_unchecked(Index n1, Index n2)       { return this->elem[n1*d2+n2]; }
+    const T& at_unchecked(Index n1, Index n2) const { return this->elem[n1*d2+n2]; }
+
+    // the elements of row n as a pointer range, not range checked (an inner loop needs no d2):
+          T* row_begin(Index n)       { return this->elem+n*d2; }
+    const T* row_begin(Index n) const { return this->elem+n*d2; }
+          T* row_end(Index n)         { return this->elem+(n+1)*d2; }
+    const T* row_end(Index n) const   { return this->elem+(n+1)*d2; }
+
     // slicing (return a row):
-          Row<T,1> operator[](Index n)       { return row(n); }
-    const Row<T,1> operator[](Index n) const { return row(n); }
+          Row<T,1,A> operator[](Index n)       { return row(n); }
+    const Row<T,1,A> operator[](Index n) const { return row(n); }
 
-          Row<T,1> row(Index n)       { range_check(n,0); return Row<T,1>(d2,&this->elem[n*d2]); }
-    const Row<T,1> row(Index n) const { range_check(n,0); return Row<T,1>(d2,&this->elem[n*d2]); }
+          Row<T,1,A> row(Index n)       { range_check(n,0); return Row<T,1,A>(d2,&this->elem[n*d2],this->alloc); }
+    const Row<T,1,A> row(Index n) const { range_check(n,0); return Row<T,1,A>(d2,&this->elem[n*d2],this->alloc); }
 
-    Row<T,2> slice(Index n)
+    Row<T,2,A> slice(Index n)
         // rows [n:d1)
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;    // one beyond the end
-        return Row<T,2>(d1-n,d2,this->elem+n*d2);
+        return Row<T,2,A>(d1-n,d2,this->elem+n*d2,this->alloc);
     }
 
-    const Row<T,2> slice(Index n) const
+    const Row<T,2,A> slice(Index n) const
         // rows [n:d1)
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;    // one beyond the end
-        return Row<T,2>(d1-n,d2,this->elem+n*d2);
+        return Row<T,2,A>(d1-n,d2,this->elem+n*d2,this->alloc);
     }
 
-    Row<T,2> slice(Index n, Index m)
+    Row<T,2,A> slice(Index n, Index m)
         // the rows [n:m)
     {
         if (n<0) n=0;
         if(d1<m) m=d1;    // one beyond the end
-        return Row<T,2>(m-n,d2,this->elem+n*d2);
+        return Row<T,2,A>(m-n,d2,this->elem+n*d2,this->alloc);
 
     }
 
-    const Row<T,2> slice(Index n, Index m) const
+    const Row<T,2,A> slice(Index n, Index m) const
         // the rows [n:sz)
     {
         if (n<0) n=0;
         if(d1<m) m=d1;    // one beyond the end
-        return Row<T,2>(m-n,d2,this->elem+n*d2);
+        return Row<T,2,A>(m-n,d2,this->elem+n*d2,this->alloc);
     }
 
     // Column<T,1> column(Index n); // not (yet) implemented: requies strides and operations on columns
@@ -496,11 +850,11 @@ public:
     Matrix& operator|=(const T& c) { this->base_apply(Or_assign<T>(),c);    return *this; }
     Matrix& operator^=(const T& c) { this->base_apply(Xor_assign<T>(),c);   return *this; }
 
-    Matrix operator!() { return xfer(Matrix(*this,Not<T>())); }
-    Matrix operator-() { return xfer(Matrix(*this,Unary_minus<T>())); }
-    Matrix operator~() { return xfer(Matrix(*this,Complement<T>()));  }
+    Matrix operator!() { return Matrix(*this,Not<T>()); }
+    Matrix operator-() { return Matrix(*this,Unary_minus<T>()); }
+    Matrix operator~() { return Matrix(*this,Complement<T>());  }
 
-    template<class F> Matrix apply_new(F f) { return xfer(Matrix(*this,f)); }
+    template<class F> Matrix apply_new(F f) { return Matrix(*this,f); }
     
     void swap_rows(Index i, Index j)
         // swap_rows() uses a row's worth of memory for better run-time performance
@@ -508,7 +862,7 @@ public:
     {
         if (i == j) return;
     /*
-        Matrix<T,1> temp = (*this)[i];
+        Matrix<T,1,A> temp = (*this)[i];
         (*this)[i] = (*this)[j];
         (*this)[j] = temp;
     */
@@ -519,36 +873,52 @@ public:
 
 //-----------------------------------------------------------------------------
 
-template<class T> class Matrix<T,3> : public Matrix_base<T> {
-    const Index d1;
-    const Index d2;
-    const Index d3;
+template<class T, class A> class Matrix<T,3,A> : public Matrix_base<T,A> {
+    Index d1;
+    Index d2;
+    Index d3;
 
 protected:
     // for use by Row:
-    Matrix(Index n1, Index n2, Index n3, T* p) : Matrix_base<T>(n1*n2*n3,p), d1(n1), d2(n2), d3(n3) 
+    Matrix(Index n1, Index n2, Index n3, T* p, const A& a = A()) : Matrix_base<T,A>(n1*n2*n3,p,a), d1(n1), d2(n2), d3(n3) 
     {
         // std::cerr << "construct 3D Matrix from data\n";
     }
 
 public:
 
-    Matrix(Index n1, Index n2, Index n3) : Matrix_base<T>(n1*n2*n3), d1(n1), d2(n2), d3(n3) { }
+    Matrix(Index n1, Index n2, Index n3, const A& a = A()) : Matrix_base<T,A>(n1*n2*n3,a), d1(n1), d2(n2), d3(n3) { }
+    Matrix(Index n1, Index n2, Index n3, No_init, const A& a = A()) : Matrix_base<T,A>(n1*n2*n3,No_init(),a), d1(n1), d2(n2), d3(n3) { }
 
-    Matrix(Row<T,3>& a) : Matrix_base<T>(a.dim1()*a.dim2()*a.dim3(),a.p), d1(a.dim1()), d2(a.dim2()), d3(a.dim3())
+    Matrix(Row<T,3,A>& a) : Matrix_base<T,A>(a.dim1()*a.dim2()*a.dim3(),a.p), d1(a.dim1()), d2(a.dim2()), d3(a.dim3())
     { 
         // std::cerr << "construct 3D Matrix from Row\n";
     }
 
+    // a Row given by value (such as m[i]) is copied, so the new Matrix does not share its elements:
+    Matrix(Row<T,3,A>&& a) : Matrix(static_cast<const Matrix&>(a)) { }
+
     // copy constructor: let the base do the copy:
-    Matrix(const Matrix& a) : Matrix_base<T>(a.size(),0), d1(a.d1), d2(a.d2), d3(a.d3)
+    Matrix(const Matrix& a) : Matrix_base<T,A>(a.size(),0,a.alloc), d1(a.d1), d2(a.d2), d3(a.d3)
     {
         // std::cerr << "copy ctor\n";
         this->base_copy(a);
     }
 
+    // move constructor: take a's elements, so returning a Matrix by value never copies:
+    Matrix(Matrix&& a) noexcept : Matrix_base<T,A>(std::move(a)), d1(a.d1), d2(a.d2), d3(a.d3)
+    {
+        if (this->owns) { a.d1 = 0; a.d2 = 0; a.d3 = 0; }    // a descriptor is left alone
+    }
+
+    // evaluate an expression such as a*c+b in one pass, with no temporaries:
+    template<class E> Matrix(const E& e, typename If_expr<E>::type* = 0) : Matrix_base<T,A>(e.size(),0,allocator_from<A>(e.shape().get_allocator())), d1(e.shape().dim1()), d2(e.shape().dim2()), d3(e.shape().dim3())
+    {
+        this->base_eval(e);
+    }
+
     template<int n1, int n2, int n3> 
-    Matrix(const T (&a)[n1][n2][n3]) : Matrix_base<T>(n1*n2), d1(n1), d2(n2), d3(n3)
+    Matrix(const T (&a)[n1][n2][n3]) : Matrix_base<T,A>(n1*n2*n3,No_init()), d1(n1), d2(n2), d3(n3)
         // deduce "n1", "n2", "n3" (and "T"), Matrix_base allocates T[n1*n2*n3]
     {
         // std::cerr << "matrix ctor\n";
@@ -558,7 +928,7 @@ public:
                     this->elem[i*n2*n3+j*n3+k]=a[i][j][k];
     }
 
-    template<class F> Matrix(const Matrix& a, F f) : Matrix_base<T>(a.size()), d1(a.d1), d2(a.d2), d3(a.d3)
+    template<class F> Matrix(const Matrix& a, F f) : Matrix_base<T,A>(a.size(),No_init(),a.alloc), d1(a.d1), d2(a.d2), d3(a.d3)
         // construct a new Matrix with element's that are functions of a's elements:
         // does not modify a unless f has been specifically programmed to modify its argument
         // T f(const T&) would be a typical type for f
@@ -566,7 +936,7 @@ public:
         for (Index i = 0; i<this->sz; ++i) this->elem[i] = f(a.elem[i]); 
     }
 
-    template<class F, class Arg> Matrix(const Matrix& a, F f, const Arg& t1) : Matrix_base<T>(a.size()), d1(a.d1), d2(a.d2), d3(a.d3)
+    template<class F, class Arg> Matrix(const Matrix& a, F f, const Arg& t1) : Matrix_base<T,A>(a.size(),No_init(),a.alloc), d1(a.d1), d2(a.d2), d3(a.d3)
         // construct a new Matrix with element's that are functions of a's elements:
         // does not modify a unless f has been specifically programmed to modify its argument
         // T f(const T&, const Arg&) would be a typical type for f
@@ -575,11 +945,34 @@ public:
     }
 
     Matrix& operator=(const Matrix& a)
-        // copy assignment: let the base do the copy
+        // copy assignment: let the base do the copy;
+        // a Matrix that owns its elements takes a's shape, a Row must already have it
     {
         // std::cerr << "copy assignment (" << this->size() << ',' << a.size()<< ")\n";
-        if (d1!=a.d1 || d2!=a.d2 || d3!=a.d3) error("length error in 2D =");
+        if (!this->owns && (d1!=a.d1 || d2!=a.d2 || d3!=a.d3)) error("length error in 2D =");
         this->base_assign(a);
+        d1 = a.d1; d2 = a.d2; d3 = a.d3;
+        return *this;
+    }
+
+    Matrix& operator=(Matrix&& a)
+        // move assignment: take a's elements and shape, or copy if either is a Row
+    {
+        if (!this->base_move(a)) return *this = static_cast<const Matrix&>(a);
+        if (this!=&a) {
+            d1 = a.d1; d2 = a.d2; d3 = a.d3;
+            a.d1 = 0; a.d2 = 0; a.d3 = 0;
+        }
+        return *this;
+    }
+
+    template<class E> typename If_expr<E,Matrix&>::type operator=(const E& e)
+        // assignment of an expression writes straight into the elements
+    {
+        if (!this->owns && (d1!=e.shape().dim1() || d2!=e.shape().dim2() || d3!=e.shape().dim3())) error("length error in 3D =");
+        Index n1 = e.shape().dim1(); Index n2 = e.shape().dim2(); Index n3 = e.shape().dim3();
+        this->base_assign_expr(e);
+        d1 = n1; d2 = n2; d3 = n3;
         return *this;
     }
 
@@ -589,63 +982,73 @@ public:
     Index dim2() const { return d2; }    // number of elements in a column
     Index dim3() const { return d3; }    // number of elements in a depth
 
-    Matrix xfer()    // make an Matrix to move elements out of a scope
+    Matrix xfer()    // the old way to move elements out of a scope: now the same as std::move(*this),
+                     // except that the elements of a Row (or any Matrix that does not own them) are copied
     {
-        Matrix x(dim1(),dim2(),dim3(),this->data()); // make a descriptor
-        this->base_xfer(x);            // transfer (temporary) ownership to x
-        return x;
+        if (!this->owns) return Matrix(static_cast<const Matrix&>(*this));
+        return std::move(*this);
     }
 
     void range_check(Index n1, Index n2, Index n3) const
     {
         // std::cerr << "range check: (" << d1 << "," << d2 << "): " << n1 << " " << n2 << "\n";
-        if (n1<0 || d1<=n1) error("3D range error: dimension 1");
-        if (n2<0 || d2<=n2) error("3D range error: dimension 2");
-        if (n3<0 || d3<=n3) error("3D range error: dimension 3");
+        if (out_of_range(n1,d1)) error("3D range error: dimension 1");
+        if (out_of_range(n2,d2)) error("3D range error: dimension 2");
+        if (out_of_range(n3,d3)) error("3D range error: dimension 3");
     }
 
     // subscripting:
           T& operator()(Index n1, Index n2, Index n3)       { range_check(n1,n2,n3); return this->elem[d2*d3*n1+d3*n2+n3]; }; 
     const T& operator()(Index n1, Index n2, Index n3) const { range_check(n1,n2,n3); return this->elem[d2*d3*n1+d3*n2+n3]; };
 
+    // subscripting without range checking:
+          T& at_unchecked(Index n1, Index n2, Index n3)       { return this->elem[(n1*d2+n2)*d3+n3]; }
+    const T& at_unchecked(Index n1, Index n2, Index n3) const { return this->elem[(n1*d2+n2)*d3+n3]; }
+
+    // the elements of row n (a d2 by d3 Matrix) as a pointer range, not range checked:
+          T* row_begin(Index n)       { return this->elem+n*d2*d3; }
+    const T* row_begin(Index n) const { return this->elem+n*d2*d3; }
+          T* row_end(Index n)         { return this->elem+(n+1)*d2*d3; }
+    const T* row_end(Index n) const   { return this->elem+(n+1)*d2*d3; }
+
     // slicing (return a row):
-          Row<T,2> operator[](Index n)       { return row(n); }
-    const Row<T,2> operator[](Index n) const { return row(n); }
+          Row<T,2,A> operator[](Index n)       { return row(n); }
+    const Row<T,2,A> operator[](Index n) const { return row(n); }
 
-          Row<T,2> row(Index n)       { range_check(n,0,0); return Row<T,2>(d2,d3,&this->elem[n*d2*d3]); }
-    const Row<T,2> row(Index n) const { range_check(n,0,0); return Row<T,2>(d2,d3,&this->elem[n*d2*d3]); }
+          Row<T,2,A> row(Index n)       { range_check(n,0,0); return Row<T,2,A>(d2,d3,&this->elem[n*d2*d3],this->alloc); }
+    const Row<T,2,A> row(Index n) const { range_check(n,0,0); return Row<T,2,A>(d2,d3,&this->elem[n*d2*d3],this->alloc); }
 
-    Row<T,3> slice(Index n)
+    Row<T,3,A> slice(Index n)
         // rows [n:d1)
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;    // one beyond the end
-        return Row<T,3>(d1-n,d2,d3,this->elem+n*d2*d3);
+        return Row<T,3,A>(d1-n,d2,d3,this->elem+n*d2*d3,this->alloc);
     }
 
-    const Row<T,3> slice(Index n) const
+    const Row<T,3,A> slice(Index n) const
         // rows [n:d1)
     {
         if (n<0) n=0;
         else if(d1<n) n=d1;    // one beyond the end
-        return Row<T,3>(d1-n,d2,d3,this->elem+n*d2*d3);
+        return Row<T,3,A>(d1-n,d2,d3,this->elem+n*d2*d3,this->alloc);
     }
 
-    Row<T,3> slice(Index n, Index m)
+    Row<T,3,A> slice(Index n, Index m)
         // the rows [n:m)
     {
         if (n<0) n=0;
         if(d1<m) m=d1;    // one beyond the end
-        return Row<T,3>(m-n,d2,d3,this->elem+n*d2*d3);
+        return Row<T,3,A>(m-n,d2,d3,this->elem+n*d2*d3,this->alloc);
 
     }
 
-    const Row<T,3> slice(Index n, Index m) const
+    const Row<T,3,A> slice(Index n, Index m) const
         // the rows [n:sz)
     {
         if (n<0) n=0;
         if(d1<m) m=d1;    // one beyond the end
-        return Row<T,3>(m-n,d2,d3,this->elem+n*d2*d3);
+        return Row<T,3,A>(m-n,d2,d3,this->elem+n*d2*d3,this->alloc);
     }
 
     // Column<T,2> column(Index n); // not (yet) implemented: requies strides and operations on columns
@@ -666,11 +1069,11 @@ public:
     Matrix& operator|=(const T& c) { this->base_apply(Or_assign<T>(),c);    return *this; }
     Matrix& operator^=(const T& c) { this->base_apply(Xor_assign<T>(),c);   return *this; }
 
-    Matrix operator!() { return xfer(Matrix(*this,Not<T>())); }
-    Matrix operator-() { return xfer(Matrix(*this,Unary_minus<T>())); }
-    Matrix operator~() { return xfer(Matrix(*this,Complement<T>()));  }
+    Matrix operator!() { return Matrix(*this,Not<T>()); }
+    Matrix operator-() { return Matrix(*this,Unary_minus<T>()); }
+    Matrix operator~() { return Matrix(*this,Complement<T>());  }
 
-    template<class F> Matrix apply_new(F f) { return xfer(Matrix(*this,f)); }
+    template<class F> Matrix apply_new(F f) { return Matrix(*this,f); }
     
     void swap_rows(Index i, Index j)
         // swap_rows() uses a row's worth of memory for better run-time performance
@@ -678,7 +1081,7 @@ public:
     {
         if (i == j) return;
         
-        Matrix<T,2> temp = (*this)[i];
+        Matrix<T,2,A> temp = (*this)[i];
         (*this)[i] = (*this)[j];
         (*this)[j] = temp;
     }
@@ -686,19 +1089,16 @@ public:
 
 //-----------------------------------------------------------------------------
 
-template<class T> Matrix<T> scale_and_add(const Matrix<T>& a, T c, const Matrix<T>& b)
+template<class T, class A> Matrix<T,1,A> scale_and_add(const Matrix<T,1,A>& a, T c, const Matrix<T,1,A>& b)
     //  Fortran "saxpy()" ("fma" for "fused multiply-add").
-    // will the copy constructor be called twice and defeat the xfer optimization?
 {
     if (a.size() != b.size()) error("sizes wrong for scale_and_add()");
-    Matrix<T> res(a.size());
-    for (Index i = 0; i<a.size(); ++i) res[i] += a[i]*c+b[i];
-    return res.xfer();
+    return Matrix<T,1,A>(a*c+b);    // one allocation and one pass, moved out
 }
 
 //-----------------------------------------------------------------------------
 
-template<class T> T dot_product(const Matrix<T>&a , const Matrix<T>& b)
+template<class T, class A> T dot_product(const Matrix<T,1,A>&a , const Matrix<T,1,A>& b)
 {
     if (a.size() != b.size()) error("sizes wrong for dot product");
     T sum = 0;
@@ -708,20 +1108,25 @@ template<class T> T dot_product(const Matrix<T>&a , const Matrix<T>& b)
 
 //-----------------------------------------------------------------------------
 
-template<class T, int N> Matrix<T,N> xfer(Matrix<T,N>& a)
+template<class T, int N, class A> Matrix<T,N,A> xfer(Matrix<T,N,A>& a)
 {
     return a.xfer();
 }
 
 //-----------------------------------------------------------------------------
 
-template<class F, class A>            A apply(F f, A x)        { A res(x,f);   return xfer(res); }
-template<class F, class Arg, class A> A apply(F f, A x, Arg a) { A res(x,f,a); return xfer(res); }
+template<class F, class A>            A apply(F f, A x)        { return A(x,f); }
+template<class F, class Arg, class A> A apply(F f, A x, Arg a) { return A(x,f,a); }
 
 //-----------------------------------------------------------------------------
 
 // The default values for T and D have been declared before.
-template<class T, int D> class Row {
+// A Row is a descriptor for part of a Matrix: moving one moves the descriptor, and
+// assigning to one (copy or move) writes into that part of the Matrix. A Matrix made
+// from a Row, such as Matrix<double> v = m[i], has a copy of the elements. A Row that
+// only binds to a Matrix&&, as in v.push_back(m[i]), is still moved as a descriptor:
+// write v.push_back(Matrix<double>(m[i])) to keep a copy.
+template<class T, int D, class A> class Row {
     // general version exists only to allow specializations
 private:
         Row();
@@ -729,73 +1134,376 @@ private:
 
 //-----------------------------------------------------------------------------
 
-template<class T> class Row<T,1> : public Matrix<T,1> {
+template<class T, class A> class Row<T,1,A> : public Matrix<T,1,A> {
 public:
-    Row(Index n, T* p) : Matrix<T,1>(n,p)
+    Row(Index n, T* p, const A& a = A()) : Matrix<T,1,A>(n,p,a)
+    {
+    }
+
+    Row(Row&& a) noexcept : Matrix<T,1,A>(a.dim1(),a.data(),a.get_allocator()) { }    // the same part of the same Matrix
+    Row(const Row& a) : Matrix<T,1,A>(a) { }    // a copy (of a const Row, say) has its own elements
+
+    Matrix<T,1,A>& operator=(const T& c) { this->base_apply(Assign<T>(),c); return *this; }
+
+    Matrix<T,1,A>& operator=(const Matrix<T,1,A>& a)
     {
+        return *static_cast<Matrix<T,1,A>*>(this)=a;
     }
 
-    Matrix<T,1>& operator=(const T& c) { this->base_apply(Assign<T>(),c); return *this; }
+    Matrix<T,1,A>& operator=(const Row& a)
+    {
+        return *static_cast<Matrix<T,1,A>*>(this)=a;
+    }
 
-    Matrix<T,1>& operator=(const Matrix<T,1>& a)
+    template<class E> typename If_expr<E,Matrix<T,1,A>&>::type operator=(const E& e)
     {
-        return *static_cast<Matrix<T,1>*>(this)=a;
+        return *static_cast<Matrix<T,1,A>*>(this)=e;
     }
 };
 
 //-----------------------------------------------------------------------------
 
-template<class T> class Row<T,2> : public Matrix<T,2> {
+template<class T, class A> class Row<T,2,A> : public Matrix<T,2,A> {
 public:
-    Row(Index n1, Index n2, T* p) : Matrix<T,2>(n1,n2,p)
+    Row(Index n1, Index n2, T* p, const A& a = A()) : Matrix<T,2,A>(n1,n2,p,a)
     {
     }
+
+    Row(Row&& a) noexcept : Matrix<T,2,A>(a.dim1(),a.dim2(),a.data(),a.get_allocator()) { }    // the same part of the same Matrix
+    Row(const Row& a) : Matrix<T,2,A>(a) { }    // a copy (of a const Row, say) has its own elements
         
-    Matrix<T,2>& operator=(const T& c) { this->base_apply(Assign<T>(),c); return *this; }
+    Matrix<T,2,A>& operator=(const T& c) { this->base_apply(Assign<T>(),c); return *this; }
+
+    Matrix<T,2,A>& operator=(const Matrix<T,2,A>& a)
+    {
+        return *static_cast<Matrix<T,2,A>*>(this)=a;
+    }
+
+    Matrix<T,2,A>& operator=(const Row& a)
+    {
+        return *static_cast<Matrix<T,2,A>*>(this)=a;
+    }
 
-    Matrix<T,2>& operator=(const Matrix<T,2>& a)
+    template<class E> typename If_expr<E,Matrix<T,2,A>&>::type operator=(const E& e)
     {
-        return *static_cast<Matrix<T,2>*>(this)=a;
+        return *static_cast<Matrix<T,2,A>*>(this)=e;
     }
 };
 
 //-----------------------------------------------------------------------------
 
-template<class T> class Row<T,3> : public Matrix<T,3> {
+template<class T, class A> class Row<T,3,A> : public Matrix<T,3,A> {
 public:
-    Row(Index n1, Index n2, Index n3, T* p) : Matrix<T,3>(n1,n2,n3,p)
+    Row(Index n1, Index n2, Index n3, T* p, const A& a = A()) : Matrix<T,3,A>(n1,n2,n3,p,a)
+    {
+    }
+
+    Row(Row&& a) noexcept : Matrix<T,3,A>(a.dim1(),a.dim2(),a.dim3(),a.data(),a.get_allocator()) { }    // the same part of the same Matrix
+    Row(const Row& a) : Matrix<T,3,A>(a) { }    // a copy (of a const Row, say) has its own elements
+
+    Matrix<T,3,A>& operator=(const T& c) { this->base_apply(Assign<T>(),c); return *this; }
+
+    Matrix<T,3,A>& operator=(const Matrix<T,3,A>& a)
+    {
+        return *static_cast<Matrix<T,3,A>*>(this)=a;
+    }
+
+    Matrix<T,3,A>& operator=(const Row& a)
+    {
+        return *static_cast<Matrix<T,3,A>*>(this)=a;
+    }
+
+    template<class E> typename If_expr<E,Matrix<T,3,A>&>::type operator=(const E& e)
     {
+        return *static_cast<Matrix<T,3,A>*>(this)=e;
     }
+};
+
+//-----------------------------------------------------------------------------
+
+// A Fixed_matrix has its dimensions as template arguments (0 for "no such dimension"):
+// Fixed_matrix<double,3,4> is a 3 by 4 Matrix. Its elements are in the object itself,
+// so it needs no allocation, and its strides are constants, so (i,j) folds to shifts and
+// adds and the range check compares against constants. It is not a Matrix, but view()
+// gives a Matrix (a Row) that refers to its elements, for the operations on Matrices.
+template<class T, Index N1, Index N2 = 0, Index N3 = 0> class Fixed_matrix {
+    static_assert(N1>0 && N2>=0 && N3>=0 && (N2>0 || N3==0), "Fixed_matrix dimensions must be positive");
+    static const Index S2 = N2 ? N2 : 1;    // extents, 1 for a missing dimension
+    static const Index S3 = N3 ? N3 : 1;
 
-    Matrix<T,3>& operator=(const T& c) { this->base_apply(Assign<T>(),c); return *this; }
+    alignas(64) T elem[N1*S2*S3];
 
-    Matrix<T,3>& operator=(const Matrix<T,3>& a)
+    static void range_check(Index n, Index d, const char* s) { if (out_of_range(n,d)) error(s); }
+public:
+    static const int dims = N3 ? 3 : N2 ? 2 : 1;
+
+    Fixed_matrix() : elem() { }    // value initialized, as a Matrix is
+    explicit Fixed_matrix(No_init) { }
+
+    static Index dim1() { return N1; }
+    static Index dim2() { return N2; }
+    static Index dim3() { return N3; }
+    static Index size() { return N1*S2*S3; }
+
+          T* data()        { return elem; }
+    const T* data() const  { return elem; }
+          T* begin()       { return elem; }
+    const T* begin() const { return elem; }
+          T* end()         { return elem+size(); }
+    const T* end() const   { return elem+size(); }
+
+    // subscripting, for as many subscripts as there are dimensions:
+    T& operator()(Index n1)
+    {
+        static_assert(dims==1, "wrong number of subscripts for Fixed_matrix");
+        range_check(n1,N1,"Fixed_matrix range error: dimension 1");
+        return elem[n1];
+    }
+    T& operator()(Index n1, Index n2)
+    {
+        static_assert(dims==2, "wrong number of subscripts for Fixed_matrix");
+        range_check(n1,N1,"Fixed_matrix range error: dimension 1");
+        range_check(n2,S2,"Fixed_matrix range error: dimension 2");
+        return elem[n1*S2+n2];
+    }
+    T& operator()(Index n1, Index n2, Index n3)
     {
-        return *static_cast<Matrix<T,3>*>(this)=a;
+        static_assert(dims==3, "wrong number of subscripts for Fixed_matrix");
+        range_check(n1,N1,"Fixed_matrix range error: dimension 1");
+        range_check(n2,S2,"Fixed_matrix range error: dimension 2");
+        range_check(n3,S3,"Fixed_matrix range error: dimension 3");
+        return elem[(n1*S2+n2)*S3+n3];
     }
+    const T& operator()(Index n1) const                     { return const_cast<Fixed_matrix&>(*this)(n1); }
+    const T& operator()(Index n1, Index n2) const           { return const_cast<Fixed_matrix&>(*this)(n1,n2); }
+    const T& operator()(Index n1, Index n2, Index n3) const { return const_cast<Fixed_matrix&>(*this)(n1,n2,n3); }
+
+    // subscripting without range checking (missing subscripts are 0):
+          T& at_unchecked(Index n1, Index n2 = 0, Index n3 = 0)       { return elem[(n1*S2+n2)*S3+n3]; }
+    const T& at_unchecked(Index n1, Index n2 = 0, Index n3 = 0) const { return elem[(n1*S2+n2)*S3+n3]; }
+
+    // the elements of row n as a pointer range, not range checked:
+          T* row_begin(Index n)       { return elem+n*S2*S3; }
+    const T* row_begin(Index n) const { return elem+n*S2*S3; }
+          T* row_end(Index n)         { return elem+(n+1)*S2*S3; }
+    const T* row_end(Index n) const   { return elem+(n+1)*S2*S3; }
+
+    Fixed_matrix& operator=(const T& c) { for (Index i = 0; i<size(); ++i) elem[i] = c; return *this; }
+
+    Row<T,dims> view() { return make_view(std::integral_constant<int,dims>()); }
+private:
+    Row<T,1> make_view(std::integral_constant<int,1>) { return Row<T,1>(N1,elem); }
+    Row<T,2> make_view(std::integral_constant<int,2>) { return Row<T,2>(N1,N2,elem); }
+    Row<T,3> make_view(std::integral_constant<int,3>) { return Row<T,3>(N1,N2,N3,elem); }
 };
 
 //-----------------------------------------------------------------------------
 
-template<class T, int N> Matrix<T,N-1> scale_and_add(const Matrix<T,N>& a, const Matrix<T,N-1> c, const Matrix<T,N-1>& b)
+template<class T, int N, class A> Matrix<T,N-1,A> scale_and_add(const Matrix<T,N,A>& a, const Matrix<T,N-1,A>& c, const Matrix<T,N-1,A>& b)
 {
-    Matrix<T> res(a.size());
+    Matrix<T,1,A> res(a.size());
     if (a.size() != b.size()) error("sizes wrong for scale_and_add");
     for (Index i = 0; i<a.size(); ++i) res[i] += a[i]*c+b[i];
-    return res.xfer();
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+
+// Expression templates for element-wise arithmetic:
+// an operator on a Matrix (or a Row, or another expression) and a scalar, or on two
+// Matrices of the same shape, does no arithmetic; it returns a small node that
+// remembers its operands, and a chain such as (a*c+b)&mask is a tree of nodes.
+// Constructing or assigning a Matrix from the tree computes every element in a
+// single loop, with no temporary Matrices and one pass over memory.
+// A node refers to the Matrices it was built from, so keep it only as long as they
+// live (beware "auto e = a*c;"), and call eval() to pass it to a function template
+// such as dot_product() that needs a Matrix.
+
+template<class T> struct Times_op   { static T apply(const T& a, const T& b) { return a*b; } };
+template<class T> struct Divide_op  { static T apply(const T& a, const T& b) { return a/b; } };
+template<class T> struct Modulo_op  { static T apply(const T& a, const T& b) { return a%b; } };
+template<class T> struct Plus_op    { static T apply(const T& a, const T& b) { return a+b; } };
+template<class T> struct Subtract_op{ static T apply(const T& a, const T& b) { return a-b; } };
+template<class T> struct Bit_and_op { static T apply(const T& a, const T& b) { return a&b; } };
+template<class T> struct Bit_or_op  { static T apply(const T& a, const T& b) { return a|b; } };
+template<class T> struct Bit_xor_op { static T apply(const T& a, const T& b) { return a^b; } };
+
+//-----------------------------------------------------------------------------
+
+template<class T, int D, class A> class Matrix_ref : public Matrix_expr {
+    // a leaf: the elements of a Matrix
+    const Matrix<T,D,A>* m;
+    const T* p;
+public:
+    typedef T value_type;
+    typedef Matrix<T,D,A> matrix_type;    // the kind of Matrix that eval() gives
+    static const int dims = D;
+
+    Matrix_ref(const matrix_type& a) : m(&a), p(a.data()) { }
+
+    T operator[](Index i) const { return p[i]; }
+    Index size() const { return m->size(); }
+    const matrix_type& shape() const { return *m; }
+};
+
+//-----------------------------------------------------------------------------
+
+// the node type for an operand: a Matrix or Row becomes a Matrix_ref, a node stays a node
+template<class X, class = void> struct Expr_of { };    // not an operand: no "type"
+template<class T, int D, class A> struct Expr_of< Matrix<T,D,A> > { typedef Matrix_ref<T,D,A> type; };
+template<class T, int D, class A> struct Expr_of< Row<T,D,A> >    { typedef Matrix_ref<T,D,A> type; };
+template<class X> struct Expr_of<X, typename If_expr<X>::type> { typedef X type; };
+
+// (the allocators may differ: the result takes the left operand's)
+template<class T, class A, class B> bool same_shape(const Matrix<T,1,A>& a, const Matrix<T,1,B>& b) { return a.dim1()==b.dim1(); }
+template<class T, class A, class B> bool same_shape(const Matrix<T,2,A>& a, const Matrix<T,2,B>& b) { return a.dim1()==b.dim1() && a.dim2()==b.dim2(); }
+template<class T, class A, class B> bool same_shape(const Matrix<T,3,A>& a, const Matrix<T,3,B>& b)
+{
+    return a.dim1()==b.dim1() && a.dim2()==b.dim2() && a.dim3()==b.dim3();
 }
 
 //-----------------------------------------------------------------------------
 
-template<class T, int D> Matrix<T,D> operator*(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r*=c; }
-template<class T, int D> Matrix<T,D> operator/(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r/=c; }
-template<class T, int D> Matrix<T,D> operator%(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r%=c; }
-template<class T, int D> Matrix<T,D> operator+(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r+=c; }
-template<class T, int D> Matrix<T,D> operator-(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r-=c; }
+template<class A, class Op> class Scalar_expr : public Matrix_expr {
+    // a op c for each element of a
+    A a;
+    typename A::value_type c;
+public:
+    typedef typename A::value_type value_type;
+    typedef typename A::matrix_type matrix_type;
+    static const int dims = A::dims;
+
+    Scalar_expr(const A& aa, const value_type& cc) : a(aa), c(cc) { }
 
-template<class T, int D> Matrix<T,D> operator&(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r&=c; }
-template<class T, int D> Matrix<T,D> operator|(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r|=c; }
-template<class T, int D> Matrix<T,D> operator^(const Matrix<T,D>& m, const T& c) { Matrix<T,D> r(m); return r^=c; }
+    value_type operator[](Index i) const { return Op::apply(a[i],c); }
+    Index size() const { return a.size(); }
+    const matrix_type& shape() const { return a.shape(); }
+
+    matrix_type eval() const { return matrix_type(*this); }
+};
+
+//-----------------------------------------------------------------------------
+
+template<class A, class B, class Op> class Binary_expr : public Matrix_expr {
+    // a op b for each pair of elements
+    A a;
+    B b;
+public:
+    typedef typename A::value_type value_type;
+    typedef typename A::matrix_type matrix_type;
+    static const int dims = A::dims;
+
+    Binary_expr(const A& aa, const B& bb) : a(aa), b(bb)
+    {
+        if (!same_shape(a.shape(),b.shape())) error("shapes differ in element-wise operation");
+    }
+
+    value_type operator[](Index i) const { return Op::apply(a[i],b[i]); }
+    Index size() const { return a.size(); }
+    const matrix_type& shape() const { return a.shape(); }
+
+    matrix_type eval() const { return matrix_type(*this); }
+};
+
+//-----------------------------------------------------------------------------
+
+// the result types, with no "type" unless the operands are operands, so that the
+// operators below are not candidates for anything else
+
+template<class X> struct Void_of { typedef void type; };
+
+template<class X, template<class> class Op, class = void> struct Scalar_result { };
+
+template<class X, template<class> class Op>
+struct Scalar_result<X,Op,typename Void_of<typename Expr_of<X>::type>::type> {
+    typedef typename Expr_of<X>::type A;
+    typedef Scalar_expr<A,Op<typename A::value_type> > type;
+};
+
+template<class X, class Y, template<class> class Op, class = void> struct Binary_result { };
+
+template<class X, class Y, template<class> class Op>
+struct Binary_result<X,Y,Op,typename Void_of<std::pair<typename Expr_of<X>::type,typename Expr_of<Y>::type> >::type> {
+    typedef typename Expr_of<X>::type A;
+    typedef typename Expr_of<Y>::type B;
+    static_assert(std::is_same<typename A::value_type,typename B::value_type>::value && A::dims==B::dims,
+                  "element-wise operation on different kinds of Matrix");
+    typedef Binary_expr<A,B,Op<typename A::value_type> > type;
+};
+
+//-----------------------------------------------------------------------------
+
+template<class X> typename Scalar_result<X,Times_op>::type operator*(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Times_op> R; return typename R::type(typename R::A(m),c);
+}
+template<class X> typename Scalar_result<X,Divide_op>::type operator/(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Divide_op> R; return typename R::type(typename R::A(m),c);
+}
+template<class X> typename Scalar_result<X,Modulo_op>::type operator%(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Modulo_op> R; return typename R::type(typename R::A(m),c);
+}
+template<class X> typename Scalar_result<X,Plus_op>::type operator+(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Plus_op> R; return typename R::type(typename R::A(m),c);
+}
+template<class X> typename Scalar_result<X,Subtract_op>::type operator-(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Subtract_op> R; return typename R::type(typename R::A(m),c);
+}
+
+template<class X> typename Scalar_result<X,Bit_and_op>::type operator&(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Bit_and_op> R; return typename R::type(typename R::A(m),c);
+}
+template<class X> typename Scalar_result<X,Bit_or_op>::type operator|(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Bit_or_op> R; return typename R::type(typename R::A(m),c);
+}
+template<class X> typename Scalar_result<X,Bit_xor_op>::type operator^(const X& m, const typename Expr_of<X>::type::value_type& c)
+{
+    typedef Scalar_result<X,Bit_xor_op> R; return typename R::type(typename R::A(m),c);
+}
+
+//-----------------------------------------------------------------------------
+
+// element-wise operations on two Matrices (or Rows, or expressions) of the same shape:
+
+template<class X, class Y> typename Binary_result<X,Y,Times_op>::type operator*(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Times_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+template<class X, class Y> typename Binary_result<X,Y,Divide_op>::type operator/(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Divide_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+template<class X, class Y> typename Binary_result<X,Y,Modulo_op>::type operator%(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Modulo_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+template<class X, class Y> typename Binary_result<X,Y,Plus_op>::type operator+(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Plus_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+template<class X, class Y> typename Binary_result<X,Y,Subtract_op>::type operator-(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Subtract_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+
+template<class X, class Y> typename Binary_result<X,Y,Bit_and_op>::type operator&(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Bit_and_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+template<class X, class Y> typename Binary_result<X,Y,Bit_or_op>::type operator|(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Bit_or_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
+template<class X, class Y> typename Binary_result<X,Y,Bit_xor_op>::type operator^(const X& a, const Y& b)
+{
+    typedef Binary_result<X,Y,Bit_xor_op> R; return typename R::type(typename R::A(a),typename R::B(b));
+}
 
 //-----------------------------------------------------------------------------
 
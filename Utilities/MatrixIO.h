@@ -1,12 +1,27 @@
 
+#ifndef MATRIXIO_LIB
+#define MATRIXIO_LIB
+
 #include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
 #include "Matrix.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MATRIX_MAP 1
+#endif
+
 namespace Numeric_lib {
 
 //-----------------------------------------------------------------------------
 
-template<class T> std::ostream& operator<<(std::ostream& os, const Matrix<T>& v)
+template<class T, class A> std::ostream& operator<<(std::ostream& os, const Matrix<T,1,A>& v)
 {
     os << '{';
 
@@ -21,7 +36,7 @@ template<class T> std::ostream& operator<<(std::ostream& os, const Matrix<T>& v)
 
 //-----------------------------------------------------------------------------
 
-template<class T> std::ostream& operator<<(std::ostream& os, const Matrix<T,2>& m)
+template<class T, class A> std::ostream& operator<<(std::ostream& os, const Matrix<T,2,A>& m)
 {
     os << "{\n";
 
@@ -34,7 +49,7 @@ template<class T> std::ostream& operator<<(std::ostream& os, const Matrix<T,2>&
 
 //-----------------------------------------------------------------------------
 
-template<class T> std::istream& operator>>(std::istream& is, Matrix<T>& v)
+template<class T, class A> std::istream& operator>>(std::istream& is, Matrix<T,1,A>& v)
 {
     char ch;
     is >> ch;
@@ -53,7 +68,7 @@ template<class T> std::istream& operator>>(std::istream& is, Matrix<T>& v)
 
 //-----------------------------------------------------------------------------
 
-template<class T> std::istream& operator>>(std::istream& is, Matrix<T,2>& m)
+template<class T, class A> std::istream& operator>>(std::istream& is, Matrix<T,2,A>& m)
 {
     char ch;
     is >> ch;
@@ -62,9 +77,8 @@ template<class T> std::istream& operator>>(std::istream& is, Matrix<T,2>& m)
 
     for (Index i = 0; i<m.dim1(); ++i)
     {
-        Matrix<T,1> tmp(m.dim2());
-        is >> tmp;
-        m[i] = tmp;
+        Row<T,1,A> r = m[i];    // read each row in place
+        is >> r;
     }
 
     is >> ch;
@@ -76,4 +90,256 @@ template<class T> std::istream& operator>>(std::istream& is, Matrix<T,2>& m)
 
 //-----------------------------------------------------------------------------
 
+// Binary Matrix files: a 64-byte header, then the elements exactly as they are
+// in memory (so the elements of a mapped file start on a 64-byte boundary).
+// Only Matrices of numbers can be written. Open the streams with std::ios::binary.
+
+struct Matrix_file_header {
+    char magic[8];              // "NLMATRIX"
+    std::uint32_t order;        // 0x01020304 as the writing machine stores it
+    std::uint32_t version;
+    std::uint32_t kind;         // 'i' signed, 'u' unsigned, 'f' floating point
+    std::uint32_t elem_size;    // sizeof the element type
+    std::uint32_t dims;
+    std::uint32_t unused;
+    std::int64_t d[3];          // the dimensions; 1 beyond dims
+    char reserved[8];
+};
+
+static_assert(sizeof(Matrix_file_header)==64, "Matrix file header must be 64 bytes");
+
+const std::uint32_t matrix_file_order = 0x01020304;
+const std::uint32_t matrix_file_version = 1;
+
+template<class T> struct Matrix_file_kind {
+    static_assert(std::is_arithmetic<T>::value, "binary Matrix files hold only numbers");
+    static const std::uint32_t kind = std::is_floating_point<T>::value ? 'f' : std::is_signed<T>::value ? 'i' : 'u';
+};
+
+//-----------------------------------------------------------------------------
+
+template<class T> Matrix_file_header make_matrix_header(int dims, Index d1, Index d2 = 1, Index d3 = 1)
+{
+    Matrix_file_header h;
+    std::memset(&h,0,sizeof(h));
+    std::memcpy(h.magic,"NLMATRIX",8);
+    h.order = matrix_file_order;
+    h.version = matrix_file_version;
+    h.kind = Matrix_file_kind<T>::kind;
+    h.elem_size = sizeof(T);
+    h.dims = dims;
+    h.d[0] = d1;
+    h.d[1] = d2;
+    h.d[2] = d3;
+    return h;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class U> U swap_bytes(U x)
+{
+    char* p = reinterpret_cast<char*>(&x);
+    std::reverse(p,p+sizeof(U));
+    return x;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T> Index check_matrix_header(Matrix_file_header& h, int dims, bool& swapped)
+    // check that h describes a D-dimensional Matrix of T, put it in this
+    // machine's byte order, and return the number of elements;
+    // the dimensions past the D-th must be 1, so that the count is that of a D-dimensional Matrix
+{
+    if (std::memcmp(h.magic,"NLMATRIX",8)!=0) error("not a binary Matrix file");
+    swapped = h.order!=matrix_file_order;
+    if (swapped) {
+        if (swap_bytes(h.order)!=matrix_file_order) error("bad byte order in Matrix file");
+        h.version = swap_bytes(h.version);
+        h.kind = swap_bytes(h.kind);
+        h.elem_size = swap_bytes(h.elem_size);
+        h.dims = swap_bytes(h.dims);
+        for (int i = 0; i<3; ++i) h.d[i] = swap_bytes(h.d[i]);
+    }
+    if (h.version!=matrix_file_version) error("unknown Matrix file version");
+    if (h.kind!=Matrix_file_kind<T>::kind || h.elem_size!=sizeof(T)) error("wrong element type in Matrix file");
+    if (h.dims!=std::uint32_t(dims)) error("wrong number of dimensions in Matrix file");
+    Index n = 1;
+    for (int i = dims; i<3; ++i) if (h.d[i]!=1) error("bad dimensions in Matrix file");
+    for (int i = 0; i<3; ++i) {
+        if (h.d[i]<0 || (h.d[i]>0 && n>std::numeric_limits<Index>::max()/Index(sizeof(T))/h.d[i])) error("bad dimensions in Matrix file");
+        n *= h.d[i];
+    }
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+
+// make a Matrix (or, for a mapped file, a view) of the shape in a header:
+template<class T, int D> struct Matrix_file_shape;
+
+template<class T> struct Matrix_file_shape<T,1> {
+    template<class A> static Matrix<T,1,A> make(const std::int64_t* d, const A& a) { return Matrix<T,1,A>(d[0],No_init(),a); }
+    static Row<T,1> view(const std::int64_t* d, T* p) { return Row<T,1>(d[0],p); }
+    template<class A> static Matrix_file_header header(const Matrix<T,1,A>& m) { return make_matrix_header<T>(1,m.dim1()); }
+};
+
+template<class T> struct Matrix_file_shape<T,2> {
+    template<class A> static Matrix<T,2,A> make(const std::int64_t* d, const A& a) { return Matrix<T,2,A>(d[0],d[1],No_init(),a); }
+    static Row<T,2> view(const std::int64_t* d, T* p) { return Row<T,2>(d[0],d[1],p); }
+    template<class A> static Matrix_file_header header(const Matrix<T,2,A>& m) { return make_matrix_header<T>(2,m.dim1(),m.dim2()); }
+};
+
+template<class T> struct Matrix_file_shape<T,3> {
+    template<class A> static Matrix<T,3,A> make(const std::int64_t* d, const A& a) { return Matrix<T,3,A>(d[0],d[1],d[2],No_init(),a); }
+    static Row<T,3> view(const std::int64_t* d, T* p) { return Row<T,3>(d[0],d[1],d[2],p); }
+    template<class A> static Matrix_file_header header(const Matrix<T,3,A>& m) { return make_matrix_header<T>(3,m.dim1(),m.dim2(),m.dim3()); }
+};
+
+//-----------------------------------------------------------------------------
+
+template<class T, int D, class A> void write_binary(std::ostream& os, const Matrix<T,D,A>& m)
+    // the header, then the elements straight from the Matrix (a Row or slice is contiguous too)
+{
+    Matrix_file_header h = Matrix_file_shape<T,D>::header(m);
+    os.write(reinterpret_cast<const char*>(&h),sizeof(h));
+    os.write(reinterpret_cast<const char*>(m.data()),m.size()*sizeof(T));
+    if (!os) error("write error in write_binary()");
 }
+
+//-----------------------------------------------------------------------------
+
+template<class T, int D, class A> void read_binary(std::istream& is, Matrix<T,D,A>& m)
+    // a Matrix that owns its elements takes the file's shape, a Row must already have it;
+    // a file written on a machine of the other byte order is converted
+{
+    Matrix_file_header h;
+    if (!is.read(reinterpret_cast<char*>(&h),sizeof(h))) error("Matrix file header missing");
+    bool swapped = false;
+    check_matrix_header<T>(h,D,swapped);
+    Matrix<T,D,A> tmp = Matrix_file_shape<T,D>::make(h.d,m.get_allocator());
+    Index n = tmp.size();
+    if (!is.read(reinterpret_cast<char*>(tmp.data()),n*sizeof(T))) error("Matrix file too short");
+    if (swapped) for (Index i = 0; i<n; ++i) tmp.data()[i] = swap_bytes(tmp.data()[i]);
+    m = std::move(tmp);
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T, int D = 2> class Matrix_writer {
+    // writes a binary Matrix file one slice (one m[i]) at a time, for a trace whose
+    // length is not known in advance: nothing is buffered beyond what the stream buffers.
+    // The header is written first with dim1()==0 and corrected by close(),
+    // so the stream must be seekable (an ofstream, not a pipe).
+    std::ostream& os;
+    std::ostream::pos_type start;
+    Matrix_file_header h;
+    Index slice;    // elements in one slice
+    bool open;
+public:
+    explicit Matrix_writer(std::ostream& s, Index n2 = 1, Index n3 = 1)
+        // the shape of one slice: n2 (by n3) elements
+        : os(s), start(s.tellp()), h(make_matrix_header<T>(D,0,D>1?n2:1,D>2?n3:1)), slice(h.d[1]*h.d[2]), open(true)
+    {
+        os.write(reinterpret_cast<const char*>(&h),sizeof(h));
+        if (!os) error("write error in Matrix_writer");
+    }
+
+    ~Matrix_writer() { if (open) try { close(); } catch (Matrix_error&) { } }
+
+    void write(const T* p, Index n)
+        // n elements, a whole number of slices
+    {
+        if (!open || n%slice!=0) error("Matrix_writer::write(): not a whole number of slices");
+        os.write(reinterpret_cast<const char*>(p),n*sizeof(T));
+        if (!os) error("write error in Matrix_writer");
+        h.d[0] += n/slice;
+    }
+
+    template<class M> void write(const M& m) { write(m.data(),m.size()); }    // a slice, or several
+    void write(const T& x) { write(&x,1); }    // for D==1
+
+    Index count() const { return h.d[0]; }
+
+    void close()
+        // write the final dim1() into the header, and leave the stream at the end
+    {
+        if (!open) return;
+        open = false;
+        std::ostream::pos_type end = os.tellp();
+        os.seekp(start);
+        os.write(reinterpret_cast<const char*>(&h),sizeof(h));
+        os.seekp(end);
+        if (!os) error("cannot complete Matrix file header");
+    }
+private:
+    Matrix_writer(const Matrix_writer&);
+    void operator=(const Matrix_writer&);
+};
+
+//-----------------------------------------------------------------------------
+
+#ifdef MATRIX_MAP
+
+template<class T, int D = 1> class Matrix_map {
+    // a binary Matrix file mapped into memory: matrix() refers to the file's elements
+    // in place, so nothing is read or copied until an element is used.
+    // The mapping is private: writing to the Matrix changes only this process's pages.
+    // The Matrix is valid only as long as the Matrix_map, and so is one moved from it;
+    // copy matrix() (or take its xfer()) to keep the elements after the map is gone.
+    std::size_t len;
+    void* base;
+    Row<T,D> view;
+
+    static void* map_file(const std::string& name, std::size_t& len)
+    {
+        int fd = ::open(name.c_str(),O_RDONLY);
+        if (fd<0) error("cannot open Matrix file");
+        struct stat st;
+        if (::fstat(fd,&st)!=0 || std::size_t(st.st_size)<sizeof(Matrix_file_header)) {
+            ::close(fd);
+            error("Matrix file header missing");
+        }
+        len = st.st_size;
+        void* p = ::mmap(0,len,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0);
+        ::close(fd);    // the mapping keeps the file
+        if (p==MAP_FAILED) error("cannot map Matrix file");
+
+        Matrix_file_header h;
+        std::memcpy(&h,p,sizeof(h));
+        try {
+            bool swapped = false;
+            Index n = check_matrix_header<T>(h,D,swapped);
+            if (swapped) error("Matrix file is in the other byte order: use read_binary()");
+            if (len-sizeof(h)<std::size_t(n)*sizeof(T)) error("Matrix file too short");
+        }
+        catch (...) {
+            ::munmap(p,len);
+            throw;
+        }
+        return p;
+    }
+
+    static const std::int64_t* dims(void* p) { return static_cast<Matrix_file_header*>(p)->d; }
+    static T* elements(void* p) { return reinterpret_cast<T*>(static_cast<char*>(p)+sizeof(Matrix_file_header)); }
+public:
+    explicit Matrix_map(const std::string& name)
+        : len(0), base(map_file(name,len)), view(Matrix_file_shape<T,D>::view(dims(base),elements(base)))
+    {
+    }
+
+    ~Matrix_map() { ::munmap(base,len); }
+
+          Matrix<T,D>& matrix()       { return view; }
+    const Matrix<T,D>& matrix() const { return view; }
+private:
+    Matrix_map(const Matrix_map&);
+    void operator=(const Matrix_map&);
+};
+
+#endif
+
+//-----------------------------------------------------------------------------
+
+}
+
+#endif
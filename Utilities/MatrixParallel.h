@@ -0,0 +1,291 @@
+
+/*
+    parallel forms of the element-wise operations and reductions in Matrix.h,
+    for Matrices of millions of elements
+
+    The elements are cut into chunks of a fixed size, whatever the number of threads,
+    and the chunks are shared out among a pool of threads that lives as long as the
+    program. A Matrix smaller than parallel_cutoff is done on the calling thread.
+
+    A reduction computes one partial result per chunk and then combines the partial
+    results in chunk order on the calling thread, so a floating point sum comes out
+    the same on every run and on any number of threads (though not always the same
+    as the one-element-at-a-time loop of dot_product()).
+*/
+
+#ifndef MATRIX_PARALLEL_LIB
+#define MATRIX_PARALLEL_LIB
+
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<exception>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<type_traits>
+#include<vector>
+#include "Matrix.h"
+
+namespace Numeric_lib {
+
+//-----------------------------------------------------------------------------
+
+const Index parallel_chunk = 1<<15;     // elements per chunk: the unit of work and of reduction order
+const Index parallel_cutoff = 1<<17;    // fewer elements than this stay on the calling thread
+
+//-----------------------------------------------------------------------------
+
+class Matrix_pool {
+    // a fixed set of worker threads that share out the chunks of one job at a time;
+    // the calling thread works on the job too, and run() returns when every chunk is done.
+    // A job that itself calls run() (from any thread of the pool) is done serially
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;    // one job at a time
+    std::mutex m;
+    std::condition_variable start;
+    std::condition_variable finished;
+    const std::function<void(Index)>* job;
+    Index chunks;
+    std::atomic<Index> next;
+    unsigned long generation;    // counts jobs, so a worker knows a new one from the last
+    int busy;                    // workers still on the current job
+    bool stopping;
+    std::exception_ptr failure;  // the first exception thrown by a chunk
+
+    static bool& in_job() { static thread_local bool b = false; return b; }
+
+    void work()
+        // take chunks until there are none left
+    {
+        in_job() = true;
+        try {
+            for (Index c; (c = next++)<chunks; ) (*job)(c);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(m);
+            if (!failure) failure = std::current_exception();
+            next = chunks;    // skip the rest
+        }
+        in_job() = false;
+    }
+
+    void worker()
+    {
+        unsigned long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m);
+                while (!stopping && generation==seen) start.wait(lock);
+                if (stopping) return;
+                seen = generation;
+            }
+            work();
+            std::lock_guard<std::mutex> lock(m);
+            if (--busy==0) finished.notify_one();
+        }
+    }
+public:
+    explicit Matrix_pool(int threads = std::thread::hardware_concurrency())
+        // "threads" counts the calling thread
+        : job(0), chunks(0), next(0), generation(0), busy(0), stopping(false)
+    {
+        for (int i = 1; i<threads; ++i) workers.push_back(std::thread(&Matrix_pool::worker,this));
+    }
+
+    ~Matrix_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        start.notify_all();
+        for (std::thread& t : workers) t.join();
+    }
+
+    int size() const { return int(workers.size())+1; }
+
+    void run(Index n, const std::function<void(Index)>& f)
+        // f(0), f(1), ... f(n-1), in no particular order and on any thread
+    {
+        if (workers.empty() || in_job() || n<2) {
+            for (Index c = 0; c<n; ++c) f(c);
+            return;
+        }
+        std::lock_guard<std::mutex> one(run_mutex);
+        {
+            std::lock_guard<std::mutex> lock(m);
+            job = &f;
+            chunks = n;
+            next = 0;
+            failure = nullptr;
+            busy = int(workers.size());
+            ++generation;
+        }
+        start.notify_all();
+        work();
+        std::exception_ptr e;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            while (busy>0) finished.wait(lock);
+            job = 0;
+            e = failure;
+        }
+        if (e) std::rethrow_exception(e);
+    }
+private:
+    Matrix_pool(const Matrix_pool&);
+    void operator=(const Matrix_pool&);
+};
+
+//-----------------------------------------------------------------------------
+
+inline Matrix_pool& matrix_pool()
+    // the pool used by the functions below, started when first used
+{
+    static Matrix_pool pool;
+    return pool;
+}
+
+//-----------------------------------------------------------------------------
+
+inline Index parallel_chunks(Index n) { return (n+parallel_chunk-1)/parallel_chunk; }
+
+template<class F> void parallel_for(Index n, F f)
+    // f(lo,hi) for each chunk [lo,hi) of [0,n), on the pool if n is large enough
+{
+    Index chunks = parallel_chunks(n);
+    auto body = [&](Index c) { Index lo = c*parallel_chunk; f(lo,std::min(n,lo+parallel_chunk)); };
+    if (n<parallel_cutoff) {
+        for (Index c = 0; c<chunks; ++c) body(c);
+        return;
+    }
+    matrix_pool().run(chunks,body);
+}
+
+//-----------------------------------------------------------------------------
+
+// a Matrix of a's shape and allocator, with elements about to be overwritten:
+template<class T, class A> Matrix<T,1,A> uninitialized_like(const Matrix<T,1,A>& a)
+{
+    return Matrix<T,1,A>(a.dim1(),No_init(),a.get_allocator());
+}
+template<class T, class A> Matrix<T,2,A> uninitialized_like(const Matrix<T,2,A>& a)
+{
+    return Matrix<T,2,A>(a.dim1(),a.dim2(),No_init(),a.get_allocator());
+}
+template<class T, class A> Matrix<T,3,A> uninitialized_like(const Matrix<T,3,A>& a)
+{
+    return Matrix<T,3,A>(a.dim1(),a.dim2(),a.dim3(),No_init(),a.get_allocator());
+}
+
+//-----------------------------------------------------------------------------
+
+template<class F, class T, int D, class A> Matrix<T,D,A>& parallel_apply(F f, Matrix<T,D,A>& m)
+    // m.apply(f): f(x) for each element x
+{
+    T* p = m.data();
+    parallel_for(m.size(),[&](Index lo, Index hi) { F g = f; for (Index i = lo; i<hi; ++i) g(p[i]); });
+    return m;
+}
+
+template<class F, class T, int D, class A> Matrix<T,D,A>& parallel_apply(F f, Matrix<T,D,A>& m, const typename std::common_type<T>::type& c)
+    // m.apply(f,c): f(x,c) for each element x, at SIMD width within a chunk for the built-in functors
+{
+    T* p = m.data();
+    parallel_for(m.size(),[&](Index lo, Index hi) {
+        if (Simd_apply<T,Simd_op<F>::code>::apply(p+lo,hi-lo,c)) return;
+        F g = f;
+        for (Index i = lo; i<hi; ++i) g(p[i],c);
+    });
+    return m;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class F, class T, int D, class A> Matrix<T,D,A> parallel_apply_new(F f, const Matrix<T,D,A>& a)
+    // a.apply_new(f), or apply(f,a): a new Matrix of f(x) for each element x of a
+{
+    Matrix<T,D,A> res = uninitialized_like(a);
+    const T* p = a.data();
+    T* q = res.data();
+    parallel_for(a.size(),[&](Index lo, Index hi) { F g = f; for (Index i = lo; i<hi; ++i) q[i] = g(p[i]); });
+    return res;
+}
+
+template<class F, class Arg, class T, int D, class A> Matrix<T,D,A> parallel_apply_new(F f, const Matrix<T,D,A>& a, const Arg& t1)
+    // apply(f,a,t1): a new Matrix of f(x,t1) for each element x of a
+{
+    Matrix<T,D,A> res = uninitialized_like(a);
+    const T* p = a.data();
+    T* q = res.data();
+    parallel_for(a.size(),[&](Index lo, Index hi) { F g = f; for (Index i = lo; i<hi; ++i) q[i] = g(p[i],t1); });
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T, class A> Matrix<T,1,A> parallel_scale_and_add(const Matrix<T,1,A>& a, typename std::common_type<T>::type c, const Matrix<T,1,A>& b)
+{
+    if (a.size() != b.size()) error("sizes wrong for parallel_scale_and_add()");
+    Matrix<T,1,A> res = uninitialized_like(a);
+    const T* p = a.data();
+    const T* r = b.data();
+    T* q = res.data();
+    parallel_for(a.size(),[&](Index lo, Index hi) { for (Index i = lo; i<hi; ++i) q[i] = p[i]*c+r[i]; });
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T, class Op, class Part> T parallel_combine(Index n, T init, Op op, Part part)
+    // init op part(chunk 0) op part(chunk 1) ..., with the parts computed in parallel
+    // and combined in chunk order
+{
+    Index chunks = parallel_chunks(n);
+    std::unique_ptr<T[]> partial(new T[chunks]);    // not a vector: vector<bool> shares bytes
+    parallel_for(n,[&](Index lo, Index hi) { partial[lo/parallel_chunk] = part(lo,hi); });
+    T res = init;
+    for (Index c = 0; c<chunks; ++c) res = op(res,partial[c]);
+    return res;
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T, int D, class A, class Op> T parallel_reduce(const Matrix<T,D,A>& m, typename std::common_type<T>::type init, Op op)
+    // init op m[0] op m[1] ... op m[size()-1] for an associative op,
+    // grouped by chunks in a fixed way (so the result does not depend on the threads)
+{
+    const T* p = m.data();
+    return parallel_combine(m.size(),init,op,[&](Index lo, Index hi) {
+        T res = p[lo];
+        for (Index i = lo+1; i<hi; ++i) res = op(res,p[i]);
+        return res;
+    });
+}
+
+template<class T, int D, class A> T parallel_sum(const Matrix<T,D,A>& m)
+{
+    return parallel_reduce(m,T(),[](const T& x, const T& y) { return x+y; });
+}
+
+//-----------------------------------------------------------------------------
+
+template<class T, class A> T parallel_dot_product(const Matrix<T,1,A>& a, const Matrix<T,1,A>& b)
+{
+    if (a.size() != b.size()) error("sizes wrong for parallel dot product");
+    const T* p = a.data();
+    const T* q = b.data();
+    return parallel_combine(a.size(),T(),[](const T& x, const T& y) { return x+y; },[&](Index lo, Index hi) {
+        T sum = 0;
+        for (Index i = lo; i<hi; ++i) sum += p[i]*q[i];
+        return sum;
+    });
+}
+
+//-----------------------------------------------------------------------------
+
+}
+
+#endif
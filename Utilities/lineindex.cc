@@ -0,0 +1,175 @@
+#include "lineindex.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/****************************************************************
+ * Constructor.
+**/
+LineIndex::LineIndex() {
+  data_ = NULL;
+  tail_ = 0;
+}
+
+/****************************************************************
+ * Destructor.
+**/
+LineIndex::~LineIndex() {
+}
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+/****************************************************************
+ * Accessor for one line of the index.
+ *
+ * Returns:
+ *   the line, whose newline is at 'start + length'
+**/
+const LineIndex::Line& LineIndex::At(size_t which) const {
+  return lines_[which];
+}
+
+/****************************************************************
+ * Accessor for the start of the text after the last newline.
+ *
+ * Returns:
+ *   the offset of the unterminated last line, which is the
+ *   length of the buffer if the buffer ends with a newline
+**/
+size_t LineIndex::GetTail() const {
+  return tail_;
+}
+
+/****************************************************************
+ * Accessor for the number of lines that end with a newline.
+**/
+size_t LineIndex::Size() const {
+  return lines_.size();
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Function to add one line to the index.
+ *
+ * Parameters:
+ *   start - the offset of the first character
+ *   end - the offset of the newline
+ *   has_text - whether the line has any but blanks and tabs
+**/
+void LineIndex::AddLine(size_t start, size_t end, bool has_text) {
+  Line line;
+  line.start = static_cast<uint32_t>(start);
+  line.length = static_cast<uint32_t>(end - start);
+  if (!has_text) {
+    line.kind = kBlank;
+  } else if (data_[start] == '*') {
+    line.kind = kComment;
+  } else {
+    line.kind = kCode;
+  }
+  lines_.push_back(line);
+}
+
+/****************************************************************
+ * Function to index a buffer.
+ *
+ * Only lines ending in a newline are indexed; the rest of the
+ * buffer after the last newline is left at 'GetTail'. The index
+ * refers to the buffer, which must not change while it is used.
+ *
+ * Parameters:
+ *   data - the text
+ *   length - the number of characters
+**/
+void LineIndex::Build(const char *data, size_t length) {
+  data_ = data;
+  lines_.clear();
+
+  size_t start = 0;
+  bool has_text = false;
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i blank = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i cr = _mm256_set1_epi8('\r');
+  for (; i + 32 <= length; i += 32) {
+    __m256i block = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(data + i));
+    __m256i is_newline = _mm256_cmpeq_epi8(block, newline);
+    __m256i is_space = _mm256_or_si256(
+        _mm256_or_si256(is_newline, _mm256_cmpeq_epi8(block, blank)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, tab),
+                        _mm256_cmpeq_epi8(block, cr)));
+    uint64_t newlines = static_cast<uint32_t>(_mm256_movemask_epi8(is_newline));
+    uint64_t text = ~static_cast<uint32_t>(_mm256_movemask_epi8(is_space))
+                  & 0xFFFFFFFFull;
+    start = this->ScanBlock(newlines, text, i, start, has_text);
+  }
+#elif defined(__SSE2__)
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i blank = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i cr = _mm_set1_epi8('\r');
+  for (; i + 16 <= length; i += 16) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i is_newline = _mm_cmpeq_epi8(block, newline);
+    __m128i is_space = _mm_or_si128(
+        _mm_or_si128(is_newline, _mm_cmpeq_epi8(block, blank)),
+        _mm_or_si128(_mm_cmpeq_epi8(block, tab), _mm_cmpeq_epi8(block, cr)));
+    uint64_t newlines = static_cast<uint32_t>(_mm_movemask_epi8(is_newline));
+    uint64_t text = ~static_cast<uint32_t>(_mm_movemask_epi8(is_space))
+                  & 0xFFFFull;
+    start = this->ScanBlock(newlines, text, i, start, has_text);
+  }
+#endif
+
+  for (; i < length; ++i) {
+    char c = data[i];
+    if (c == '\n') {
+      this->AddLine(start, i, has_text);
+      start = i + 1;
+      has_text = false;
+    } else if (c != ' ' && c != '\t' && c != '\r') {
+      has_text = true;
+    }
+  }
+
+  tail_ = start;
+}
+
+/****************************************************************
+ * Function to add the lines that end in one block.
+ *
+ * Parameters:
+ *   newlines - a bit for each newline in the block
+ *   text - a bit for each character that is not blank
+ *   base - the offset of the block
+ *   start - the offset of the line that is open
+ *   has_text - whether the open line has text so far
+ * Returns:
+ *   the offset of the line that is open after the block
+**/
+size_t LineIndex::ScanBlock(uint64_t newlines, uint64_t text, size_t base,
+                            size_t start, bool& has_text) {
+  while (newlines != 0) {
+    int bit = __builtin_ctzll(newlines);
+    uint64_t before = (1ull << bit) - 1;
+    has_text = has_text || (text & before) != 0;
+    this->AddLine(start, base + bit, has_text);
+
+    start = base + bit + 1;
+    has_text = false;
+    text &= ~((before << 1) | 1);
+    newlines &= newlines - 1;
+  }
+  has_text = has_text || text != 0;
+  return start;
+}
@@ -0,0 +1,62 @@
+/****************************************************************
+ * Header for the 'LineIndex' class for utility programs.
+ *
+ * Author/copyright:  Duncan Buell
+ * Date: 8 May 2016
+ *
+ * This code splits a buffer of text into lines in one pass and
+ * classifies each line as blank, comment only (a '*' in column
+ * one), or code. The newlines and the blank characters are found
+ * sixteen bytes at a time with SSE2, or thirty-two with AVX2 when
+ * the compiler is allowed it, and a byte at a time otherwise.
+ *
+ * Offsets are kept in 32 bits, so a buffer may not be larger than
+ * 4 GiB.
+**/
+
+#ifndef LINEINDEX_H_
+#define LINEINDEX_H_
+
+#include <cstdlib>
+#include <stdint.h>
+#include <vector>
+
+class LineIndex {
+public:
+  enum Kind { kBlank, kComment, kCode };
+
+  struct Line {
+    uint32_t start;
+    uint32_t length;
+    uint8_t kind;
+  };
+
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+  LineIndex();
+  virtual ~LineIndex();
+
+/****************************************************************
+ * Accessors and mutators.
+**/
+  const Line& At(size_t which) const;
+  size_t GetTail() const;
+  size_t Size() const;
+
+/****************************************************************
+ * General functions.
+**/
+  void Build(const char *data, size_t length);
+
+private:
+  const char *data_;
+  size_t tail_;
+  std::vector<Line> lines_;
+
+  void AddLine(size_t start, size_t end, bool has_text);
+  size_t ScanBlock(uint64_t newlines, uint64_t text, size_t base,
+                   size_t start, bool& has_text);
+};
+
+#endif // LINEINDEX_H_
@@ -0,0 +1,281 @@
+#include "readahead.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+/****************************************************************
+ * Constructor.
+ *
+ * The ring is not allocated until 'Open', so a 'Scanner' that never
+ * reads ahead does not pay for it.
+**/
+ReadAhead::ReadAhead() {
+  for (int i = 0; i < kBufferCount; ++i) {
+    buffers_[i].data = NULL;
+    buffers_[i].length = 0;
+    buffers_[i].is_last = true;
+  }
+  has_error_ = false;
+  is_at_eof_ = true;
+  is_holding_ = false;
+  is_stopping_ = false;
+  fd_ = -1;
+  filled_ = 0;
+  head_ = 0;
+  next_ = 0;
+}
+
+/****************************************************************
+ * Destructor.
+**/
+ReadAhead::~ReadAhead() {
+  this->Close();
+}
+
+/****************************************************************
+ * General functions.
+**/
+/****************************************************************
+ * Function to stop the thread, close the file, and free the ring.
+**/
+void ReadAhead::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  has_room_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  for (int i = 0; i < kBufferCount; ++i) {
+    free(buffers_[i].data);
+    buffers_[i].data = NULL;
+  }
+
+  is_at_eof_ = true;
+  is_holding_ = false;
+  is_stopping_ = false;
+  filled_ = 0;
+  head_ = 0;
+  next_ = 0;
+}
+
+/****************************************************************
+ * Function run by the thread to fill the ring of buffers.
+ *
+ * Each buffer is filled completely unless the file ends, since a
+ * read on a networked filesystem may return less than was asked.
+ * The thread stops after the buffer that holds the end of file.
+**/
+void ReadAhead::Fill() {
+  int tail = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!is_stopping_ && filled_ == kBufferCount) {
+        has_room_.wait(lock);
+      }
+      if (is_stopping_) {
+        return;
+      }
+    }
+
+    Buffer& buffer = buffers_[tail];
+    size_t length = 0;
+    bool is_last = false;
+    bool is_bad = false;
+    while (length < kBufferSize) {
+      ssize_t count = read(fd_, buffer.data + length, kBufferSize - length);
+      if (count > 0) {
+        length += count;
+      } else if (count < 0 && errno == EINTR) {
+        continue;
+      } else {
+        is_last = true;
+        is_bad = (count < 0);
+        break;
+      }
+    }
+    buffer.length = length;
+    buffer.is_last = is_last;
+    buffer.index.Build(buffer.data, length);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      has_error_ = has_error_ || is_bad;
+      ++filled_;
+    }
+    has_data_.notify_one();
+
+    if (is_last) {
+      return;
+    }
+    tail = (tail + 1) % kBufferCount;
+  }
+}
+
+/****************************************************************
+ * Function for testing for a read error, once 'IsAtEof' is true.
+ *
+ * Returns:
+ *   true if the thread stopped early because 'read' failed
+**/
+bool ReadAhead::HasError() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return has_error_;
+}
+
+/****************************************************************
+ * Function to wait for the buffer at the head of the ring.
+ *
+ * Returns:
+ *   false if the file has been read to the end
+**/
+bool ReadAhead::Hold() {
+  if (is_holding_) {
+    return true;
+  }
+  if (is_at_eof_) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (filled_ == 0) {
+    has_data_.wait(lock);
+  }
+  is_holding_ = true;
+  next_ = 0;
+  return true;
+}
+
+/****************************************************************
+ * Function for testing for end of file.
+ *
+ * As with 'ifstream::eof', this is true once a read has run into
+ * the end of the file, not merely after the last line is read.
+ *
+ * Returns:
+ *   true if the end of the file has been read
+**/
+bool ReadAhead::IsAtEof() const {
+  return is_at_eof_;
+}
+
+/****************************************************************
+ * Function for returning the next line, as 'getline' does.
+ *
+ * The newline is read but not returned.
+ *
+ * Parameters:
+ *   line - set to the line
+ * Returns:
+ *   false if the end of file came before any character was read
+**/
+bool ReadAhead::NextLine(std::string& line) {
+  bool has_read = false;
+  line.clear();
+
+  while (this->Hold()) {
+    const Buffer& buffer = buffers_[head_];
+    if (next_ < buffer.index.Size()) {
+      const LineIndex::Line& next_line = buffer.index.At(next_);
+      line.append(buffer.data + next_line.start, next_line.length);
+      ++next_;
+      return true;
+    }
+
+    size_t tail = buffer.index.GetTail();
+    line.append(buffer.data + tail, buffer.length - tail);
+    has_read = has_read || (buffer.length > tail);
+    this->Release();
+  }
+
+  return has_read;
+}
+
+/****************************************************************
+ * Function to open a file, allocate the ring, and start reading
+ * ahead.
+ *
+ * Parameters:
+ *   filename - the name of the file to be opened
+ * Returns:
+ *   false if the file could not be opened or the ring allocated
+**/
+bool ReadAhead::Open(std::string filename) {
+  this->Close();
+
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    return false;
+  }
+  for (int i = 0; i < kBufferCount; ++i) {
+    void *data = NULL;
+    if (posix_memalign(&data, kAlignment, kBufferSize) != 0) {
+      this->Close();
+      return false;
+    }
+    buffers_[i].data = static_cast<char *>(data);
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  has_error_ = false;
+  is_at_eof_ = false;
+  thread_ = std::thread(&ReadAhead::Fill, this);
+  return true;
+}
+
+/****************************************************************
+ * Function to hand the buffer at the head of the ring back to the
+ * thread.
+**/
+void ReadAhead::Release() {
+  bool is_last = buffers_[head_].is_last;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --filled_;
+    head_ = (head_ + 1) % kBufferCount;
+  }
+  has_room_.notify_one();
+
+  is_holding_ = false;
+  is_at_eof_ = is_last;
+}
+
+/****************************************************************
+ * Function to pass over comment lines without copying them.
+ *
+ * A comment is passed over only when the line after it is in the
+ * index and is not empty, since an empty line ends a source file
+ * and the comment before it may matter to the reader.
+ *
+ * Returns:
+ *   the number of lines passed over
+**/
+int ReadAhead::SkipCommentLines() {
+  int count = 0;
+  while (this->Hold()) {
+    const Buffer& buffer = buffers_[head_];
+    const LineIndex& index = buffer.index;
+    while (next_ + 1 < index.Size() &&
+           index.At(next_).kind == LineIndex::kComment &&
+           index.At(next_ + 1).length > 0) {
+      ++next_;
+      ++count;
+    }
+    //Move on only from a buffer that is used up and ends a line.
+    if (next_ < index.Size() || index.GetTail() < buffer.length ||
+        buffer.is_last) {
+      break;
+    }
+    this->Release();
+  }
+  return count;
+}
@@ -0,0 +1,86 @@
+/****************************************************************
+ * Header for the 'ReadAhead' class for utility programs.
+ *
+ * Author/copyright:  Duncan Buell
+ * Date: 8 May 2016
+ *
+ * This code reads a file line by line, as 'getline' does on an
+ * 'ifstream', while a background thread fills a ring of large
+ * buffers ahead of the reader. On a slow or networked filesystem
+ * the reader then parses one buffer while the next ones are read.
+ *
+ * The thread also splits each buffer into lines with a 'LineIndex'
+ * as it is filled, so the reader takes lines from the index. A line
+ * that runs across two buffers is appended to the caller's string
+ * from both pieces in place; buffers are never joined.
+ *
+ * The thread only reads; it does not log, since the 'Utils' log
+ * streams are not safe to share between threads.
+**/
+
+#ifndef READAHEAD_H_
+#define READAHEAD_H_
+
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "lineindex.h"
+
+class ReadAhead {
+public:
+/****************************************************************
+ * Constructors and destructors for the class.
+**/
+  ReadAhead();
+  virtual ~ReadAhead();
+
+/****************************************************************
+ * General functions.
+**/
+  void Close();
+  bool HasError() const;
+  bool IsAtEof() const;
+  bool NextLine(std::string& line);
+  bool Open(std::string filename);
+  int SkipCommentLines();
+
+private:
+  static const int kBufferCount = 4;
+  static const size_t kBufferSize = 1 << 20;
+  static const size_t kAlignment = 4096;
+
+  struct Buffer {
+    char *data;
+    size_t length;
+    bool is_last;
+    LineIndex index;
+  };
+
+  ReadAhead(const ReadAhead&);
+  ReadAhead& operator=(const ReadAhead&);
+
+  Buffer buffers_[kBufferCount];
+  bool has_error_;
+  bool is_at_eof_;
+  bool is_holding_;
+  bool is_stopping_;
+  int fd_;
+  int filled_;
+  int head_;
+  size_t next_;
+
+  std::condition_variable has_data_;
+  std::condition_variable has_room_;
+  mutable std::mutex mutex_;
+  std::thread thread_;
+
+  void Fill();
+  bool Hold();
+  void Release();
+};
+
+#endif // READAHEAD_H_
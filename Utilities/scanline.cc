@@ -12,10 +12,53 @@ using namespace std;
 
 //stringstream ScanLine::myss;
 
+/****************************************************************
+ * Whitespace as 'operator>>' sees it.
+**/
+static inline bool IsWhite(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' ||
+         c == '\f' || c == '\r';
+}
+
+/****************************************************************
+ * Fast path for a token of decimal digits with an optional minus
+ * sign, computed as 'Utils::StringToInteger' does.
+ *
+ * Returns:
+ *   false if the token is anything else, so that the caller can
+ *   hand it to the 'Utils' function and its error handling
+**/
+template <typename T>
+static bool ParseDecimal(const char *token, size_t length,
+                         bool allow_minus, T& value) {
+  size_t i = 0;
+  bool is_negative = false;
+  if (allow_minus && length > 0 && token[0] == '-') {
+    is_negative = true;
+    i = 1;
+  }
+  if (i == length) {
+    return false;
+  }
+
+  T result = 0;
+  for (; i < length; ++i) {
+    unsigned digit = static_cast<unsigned char>(token[i]) - '0';
+    if (digit > 9) {
+      return false;
+    }
+    result = 10 * result + digit;
+  }
+
+  value = is_negative ? -result : result;
+  return true;
+}
+
 /****************************************************************
  * Constructor.
 **/
 ScanLine::ScanLine() {
+  this->OpenString("");
 }
 /****************************************************************
  * Destructor.
@@ -33,21 +76,8 @@ ScanLine::~ScanLine() {
  *   true if there are ANY more characters in the input 'string'
 **/
 bool ScanLine::HasMoreData() {
-  bool return_value = true;
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter HasMoreData" << std::endl;
-#endif
-  
-  if(scanline_ss_.eof()) {
-    return_value = false;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave HasMoreData '" << return_value << "'" << std::endl;
-#endif
-
-  return return_value;
-} 
+  return !is_at_end_;
+}
 
 /****************************************************************
  * Function 'HasNext'.
@@ -56,39 +86,37 @@ bool ScanLine::HasMoreData() {
  *   true if there are ANY more characters in the input 'string'
 **/
 bool ScanLine::HasNext() {
-  bool return_value = true;
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter HasNext" << std::endl;
-#endif
-  
-  if(scanline_ss_.eof()) {
-    return_value = false;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave HasNext '" << return_value << "'" << std::endl;
-#endif
-
-  return return_value;
-} 
+  return !is_at_end_;
+}
 
 /****************************************************************
  * Initialization. This because I can't make constructors work.
+ *
+ * The line is kept, so the caller's copy may go away.
 **/
 void ScanLine::OpenString(std::string line) {
-  std::string token;
-
 #ifdef EBUGS
   Utils::logStream << TAG << "enter OpenString '" << line << "'" << std::endl;
 #endif
-  
-  scanline_ss_.clear();
-  scanline_ss_.str(line);
+
+  line_.swap(line);
+  this->OpenView(line_.data(), line_.length());
 
 #ifdef EBUGS
   Utils::logStream << TAG << "leave OpenString" << std::endl;
 #endif
-} 
+}
+
+/****************************************************************
+ * Initialization on characters that the caller owns and keeps
+ * unchanged until the line has been read.
+**/
+void ScanLine::OpenView(const char *data, size_t length) {
+  data_ = data;
+  length_ = length;
+  cursor_ = 0;
+  is_at_end_ = false;
+}
 
 /****************************************************************
  * Function 'Next' to return the next string.
@@ -101,106 +129,100 @@ void ScanLine::OpenString(std::string line) {
  *   the 'string' version of the next token
 **/
 string ScanLine::Next() {
-  std::string token;
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter next" << std::endl;
-#endif
-  
-  token = "";
-  if(!scanline_ss_.eof()) {
-    scanline_ss_ >> token;
-  }
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave next '" << token << "'" << std::endl;
-#endif
-
-  return token;
-} 
+  const char *token = NULL;
+  size_t length = this->NextToken(&token);
+  return std::string(token, length);
+}
 
 /****************************************************************
  * Function 'NextDouble' to return the next double.
  *
- * This function does not really trap erorrs. Errors converting
- * from 'string' to 'double' simply cause crashing.
+ * As with 'operator>>', the number ends where 'strtod' stops, so
+ * '3.5abc' gives 3.5 and leaves 'abc'. A token that does not start
+ * a number gives zero and is skipped.
  *
  * Returns:
  *   the next token in the file, parsed as a 'double'
 **/
 double ScanLine::NextDouble() {
-  double local_double = 0.0;
-
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextDouble" << std::endl;
-#endif
-  
-  if(!scanline_ss_.eof()) {
-    scanline_ss_ >> local_double;
+  const char *token = NULL;
+  size_t length = this->NextToken(&token);
+  if (length == 0) {
+    return 0.0;
   }
 
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextDouble '" << nextValue << "'" << std::endl;
-#endif
+  //'strtod' needs a terminated string; most numbers fit the buffer.
+  char buffer[64];
+  std::string long_token = "";
+  const char *text = buffer;
+  if (length < sizeof(buffer)) {
+    memcpy(buffer, token, length);
+    buffer[length] = '\0';
+  } else {
+    long_token.assign(token, length);
+    text = long_token.c_str();
+  }
 
+  char *stop = NULL;
+  double local_double = strtod(text, &stop);
+  size_t used = stop - text;
+  if (used > 0 && used < length) {
+    cursor_ = (token - data_) + used;
+    is_at_end_ = false;
+  }
   return local_double;
-} 
+}
 
 /****************************************************************
  * Function 'NextInt' to return the next integer.
  *
- * This function does not really trap erorrs. Errors converting
- * from 'string' to 'int' simply cause crashing.
+ * Plain decimal tokens are converted in place; anything else goes
+ * to 'Utils::StringToInteger', which reports the error.
  *
  * Returns:
  *   the next token in the file, parsed as an 'int'
 **/
 int ScanLine::NextInt() {
-  int next_value = 0;
-  std::string token = "";
+  const char *token = NULL;
+  size_t length = this->NextToken(&token);
 
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextInt" << std::endl;
-#endif
-  
-  if(!scanline_ss_.eof()) {
-    scanline_ss_ >> token;
-    next_value = Utils::StringToInteger(token); 
+  int next_value = 0;
+  if (length > 0 && !ParseDecimal(token, length, true, next_value)) {
+    next_value = Utils::StringToInteger(std::string(token, length));
   }
 
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextInt '" << NextValue << "'" << std::endl;
-#endif
-
   return next_value;
-} 
+}
 
 /****************************************************************
  * Function 'NextLine' to return the rest of the line.
  *
- * This is just a wrapper for the 'getline' function.
+ * This reads as 'getline' does, up to and past the next newline.
  * Note that this does not trim whitespace at the beginning
  * or at the end.
  *
- * CAVEAT: We have put a max of 1024 characters that can be
- *         parsed with this function.
- *
  * Returns:
  *   the 'string' version of the rest of the line
 **/
 string ScanLine::NextLine() {
-  char xx[1025];
-  std::string token;
+  std::string token = "";
 
 #ifdef EBUGS
   Utils::logStream << TAG << "enter NextLine" << std::endl;
 #endif
-  
-  if (scanline_ss_.eof()) {
-    token = "";
-  } else {
-    scanline_ss_.getline(xx,1024);
-    token = string(xx);
+
+  if (!is_at_end_) {
+    const char *start = data_ + cursor_;
+    const char *newline = static_cast<const char *>(
+        memchr(start, '\n', length_ - cursor_));
+    if (newline == NULL) {
+      token.assign(start, length_ - cursor_);
+      cursor_ = length_;
+      is_at_end_ = true;
+    } else {
+      token.assign(start, newline - start);
+      cursor_ = (newline - data_) + 1;
+    }
   }
 
 #ifdef EBUGS
@@ -208,36 +230,60 @@ string ScanLine::NextLine() {
 #endif
 
   return token;
-} 
+}
 
 /****************************************************************
  * Function 'nextLONG' to return the next LONG.
  *
- * This function does not really trap errors. Errors converting
- * from 'string' to 'LONG' simply cause crashing.
+ * Plain decimal tokens are converted in place; anything else goes
+ * to 'Utils::StringToLONG', which reports the error.
  *
  * Returns:
  *   the next token in the file, parsed as a 'LONG'
 **/
 LONG ScanLine::NextLONG() {
+  const char *token = NULL;
+  size_t length = this->NextToken(&token);
+
   LONG next_value = 0;
-  std::string token = "";
+  if (length > 0 && !ParseDecimal(token, length, false, next_value)) {
+    next_value = Utils::StringToLONG(std::string(token, length));
+  }
 
-#ifdef EBUGS
-  Utils::logStream << TAG << "enter NextLONG" << std::endl;
-#endif
-  
-  if(!scanline_ss_.eof()) {
-    scanline_ss_ >> token;
-    next_value = Utils::StringToLONG(token); 
+  return next_value;
+}
+
+/****************************************************************
+ * Function 'NextToken' to find the next token without copying it.
+ *
+ * The token is left in the line, which must not change until the
+ * token has been used.
+ *
+ * Parameters:
+ *   token - set to point at the first character of the token
+ * Returns:
+ *   the length of the token, zero if there is none
+**/
+size_t ScanLine::NextToken(const char **token) {
+  *token = data_ + cursor_;
+  if (is_at_end_) {
+    return 0;
   }
 
-#ifdef EBUGS
-  Utils::logStream << TAG << "leave NextLONG '" << next_value << "'" << std::endl;
-#endif
+  while (cursor_ < length_ && IsWhite(data_[cursor_])) {
+    ++cursor_;
+  }
+  size_t start = cursor_;
+  while (cursor_ < length_ && !IsWhite(data_[cursor_])) {
+    ++cursor_;
+  }
+  if (cursor_ == length_) {
+    is_at_end_ = true;
+  }
 
-  return next_value;
-} 
+  *token = data_ + start;
+  return cursor_ - start;
+}
 
 /****************************************************************
  * Test function to read.
@@ -247,7 +293,7 @@ void ScanLine::zork() {
 #ifdef EBUGS
   Utils::logStream << TAG << "enter zork" << endl;
 #endif
-  
+
 // while(!scanLineSS.eof())
   while(this->hasNext()) {
     token = next();
@@ -259,5 +305,5 @@ void ScanLine::zork() {
 #ifdef EBUGS
   Utils::logStream << TAG << "leave zork" << endl;
 #endif
-} 
+}
 **/
@@ -6,6 +6,10 @@
  *
  * This code performs the utility function of being a 'Scanner'
  * for a string, analogous to what a 'Scanner' does on a file.
+ *
+ * The line is read in place with a cursor rather than through a
+ * 'stringstream', and 'HasNext' follows the stream's end of file
+ * flag: it goes false once a read has run into the end of the line.
 **/
 
 #ifndef SCANLINE_H
@@ -16,6 +20,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <time.h>
 #include <sys/time.h>
@@ -41,8 +46,6 @@ public:
 //  static stringstream zorkss;
 //  static ostringstream zorkoss;
 
- std::stringstream scanline_ss_;
-
 /****************************************************************
  * Constructors and destructors for the class. 
 **/
@@ -55,14 +58,20 @@ public:
   bool HasMoreData();
   bool HasNext();
   void OpenString(std::string line);
+  void OpenView(const char *data, size_t length);
   std::string Next();
   double NextDouble();
   int NextInt();
   LONG NextLONG();
   std::string NextLine();
+  size_t NextToken(const char **token);
 
 private:
-
+  bool is_at_end_;
+  size_t cursor_;
+  size_t length_;
+  const char *data_;
+  std::string line_;
 };
 
 #endif // SCANLINE_H
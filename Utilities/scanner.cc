@@ -4,6 +4,8 @@
  * Constructor.
 **/
 Scanner::Scanner() {
+  is_read_ahead_ = false;
+  is_string_ = false;
   scanline_.OpenString("");
 
   std::string the_next = scanline_.Next();
@@ -26,6 +28,13 @@ Scanner::~Scanner() {
  * Function to close the stream.
 **/
 void Scanner::Close() {
+  if (is_read_ahead_) {
+    read_ahead_.Close();
+    return;
+  }
+  if (is_string_) {
+    return;
+  }
   Utils::FileClose(local_stream_);
 }
 
@@ -50,15 +59,25 @@ bool Scanner::HasNext() {
 //      std::cout << TAG << "scanLine HasNext false" << std::endl;
       std::string next_line = this->NextLine();
 //      std::cout << TAG << "next line is " << NextLine << std::endl;
-      next_line = Utils::TrimBlanks(next_line);
+      //Trim in place; 'Utils::TrimBlanks' copies once per blank.
+      size_t first = next_line.find_first_not_of(' ');
+      if (first == std::string::npos) {
+        next_line.clear();
+      } else {
+        next_line.erase(next_line.find_last_not_of(' ') + 1);
+        next_line.erase(0, first);
+      }
       if (0 == next_line.length()) {
 //        std::cout << TAG << "next line exists and is blank " << NextLine << std::endl;
 //        std::cout << TAG << "leave HasNext" << std::endl;
 //        return false;
-        if (local_stream_.eof()) return false;
+        if (is_read_ahead_ ? read_ahead_.IsAtEof() :
+            is_string_ ? string_stream_.eof() : local_stream_.eof()) {
+          return false;
+        }
       } else {
 //        std::cout << TAG << "next line exists and is not blank " << NextLine << std::endl;
-        scanline_.OpenString(next_line);
+        scanline_.OpenString(std::move(next_line));
 //        std::cout << TAG << "leave HasNext" << std::endl;
         got_answer = true;
         return true;
@@ -150,12 +169,8 @@ double Scanner::NextDouble() {
 **/
 int Scanner::NextInt() {
   int return_value;
-  std::string next_token;
 
-  return_value = 0;
-  next_token = this->Next();
-
-  return_value = Utils::StringToInteger(next_token);
+  return_value = scanline_.NextInt();
 
   return return_value;
 } // int Scanner::NextInt()
@@ -180,6 +195,20 @@ std::string Scanner::NextLine() {
     return_value = scanline_.NextLine();
 //    std::cout << TAG << "scanLine hasNext " << return_value << std::endl;
   }
+  else if (is_read_ahead_)
+  {
+    read_ahead_.NextLine(return_value);
+    if (read_ahead_.IsAtEof() && read_ahead_.HasError())
+    {
+      std::cout << kTag << "read failed for '" << read_ahead_filename_
+                << "'" << std::endl;
+      exit(0);
+    }
+  }
+  else if (is_string_)
+  {
+    getline(string_stream_, return_value);
+  }
   else
   {
     getline(local_stream_, return_value);
@@ -201,12 +230,8 @@ std::string Scanner::NextLine() {
 **/
 LONG Scanner::NextLONG() {
   LONG return_value;
-  std::string next_token;
 
-  return_value = 0;
-  next_token = this->Next();
-
-  return_value = Utils::StringToLONG(next_token);
+  return_value = scanline_.NextLONG();
 
   return return_value;
 } // LONG Scanner::NextLONG()
@@ -215,6 +240,57 @@ LONG Scanner::NextLONG() {
  * Function to open a file as a 'Scanner'.
 **/
 void Scanner::OpenFile(std::string filename) {
+  is_read_ahead_ = false;
+  is_string_ = false;
   Utils::FileOpen(local_stream_, filename);
 }
 
+/****************************************************************
+ * Function to open a file as a 'Scanner' that reads ahead.
+ *
+ * A background thread reads the file in large buffers while the
+ * lines already read are being parsed, which hides the latency
+ * of a slow or networked filesystem. The file is not read through
+ * 'local_stream_'. A read that fails part way through ends the
+ * program, as a failed open does.
+**/
+void Scanner::OpenFileReadAhead(std::string filename) {
+  std::cout << kTag << "open the input file '" << filename << "'" << std::endl;
+  is_read_ahead_ = true;
+  is_string_ = false;
+  read_ahead_filename_ = filename;
+  if (!read_ahead_.Open(filename)) {
+    std::cout << kTag << "open failed for '" << filename << "'" << std::endl;
+    exit(0);
+  }
+  std::cout << kTag << "open succeeded for '" << filename << "'" << std::endl;
+}
+
+/****************************************************************
+ * Function to have a 'Scanner' read the lines of a string already
+ * in memory, such as a source received over a socket, as if they
+ * were the lines of a file.
+**/
+void Scanner::OpenString(const std::string& text) {
+  is_read_ahead_ = false;
+  is_string_ = true;
+  string_stream_.clear();
+  string_stream_.str(text);
+}
+
+/****************************************************************
+ * Function to pass over comment lines, those with a '*' in column
+ * one, without reading them into strings.
+ *
+ * Only a file opened to read ahead has the index of lines this
+ * needs; otherwise nothing is passed over.
+ *
+ * Returns:
+ *   the number of lines passed over
+**/
+int Scanner::SkipCommentLines() {
+  if (!is_read_ahead_ || scanline_.HasNext()) {
+    return 0;
+  }
+  return read_ahead_.SkipCommentLines();
+}
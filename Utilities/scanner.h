@@ -10,11 +10,13 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cstdlib>
 #include <string>
 #include <vector>
 
 #include "utils.h"
+#include "readahead.h"
 #include "scanline.h"
 
 #define NDEBUG
@@ -44,13 +46,21 @@ public:
   std::string Next();
   std::string NextLine();
   void OpenFile(std::string filename);
+  void OpenFileReadAhead(std::string filename);
+  void OpenString(const std::string& text);
+  int SkipCommentLines();
   int NextInt();
   LONG NextLONG();
 
 private:
   const std::string kTag = "SCANNER: ";
 
+  bool is_read_ahead_;
+  bool is_string_;
+  ReadAhead read_ahead_;
+  std::string read_ahead_filename_;
   ScanLine scanline_;
+  std::istringstream string_stream_;
 };
 
 #endif // SCANNER_H_
@@ -0,0 +1,222 @@
+#include "alloctracker.h"
+
+#ifdef ALLOCTRACK
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "../../Utilities/utils.h"
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'AllocTracker' for counting allocations by phase.
+ *
+ * Every block gets a small header that holds its size, so that a free
+ * can be subtracted from the live bytes. The phases are the ones that
+ * 'PhaseReport' marks, whether or not the report itself is on. Counts
+ * for a phase include the phases nested in it, and a phase that runs
+ * more than once, such as 'PrintCodeLines', is summed.
+ *
+ * The bookkeeping lives in fixed arrays so that the tracker never
+ * allocates. The totals are atomic; the phase stack belongs to the
+ * thread that runs the assembly.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const size_t kHeaderSize = 16;
+static const int kMaxPhases = 32;
+static const int kMaxDepth = 16;
+static const int kMaxName = 32;
+
+struct PhaseTotals {
+  char name[kMaxName];
+  uint64_t calls;
+  uint64_t allocations;
+  uint64_t bytes;
+  uint64_t peak_live;
+};
+
+struct OpenPhase {
+  int which;
+  uint64_t allocations;
+  uint64_t bytes;
+  uint64_t peak_live;
+};
+
+static atomic<uint64_t> total_allocations(0);
+static atomic<uint64_t> total_bytes(0);
+static atomic<uint64_t> live_bytes(0);
+static atomic<uint64_t> peak_live_bytes(0);
+
+static PhaseTotals phases[kMaxPhases];
+static int how_many_phases = 0;
+static OpenPhase open_phases[kMaxDepth];
+static atomic<int> depth(0);
+
+/******************************************************************************
+ * The replacements for the global allocation functions.
+**/
+void *operator new(size_t size) {
+  char *p = static_cast<char *>(malloc(size + kHeaderSize));
+  if (p == NULL) {
+    throw bad_alloc();
+  }
+  memcpy(p, &size, sizeof(size));
+  AllocTracker::RecordAllocation(size);
+  return p + kHeaderSize;
+}
+
+void *operator new(size_t size, const nothrow_t&) noexcept {
+  char *p = static_cast<char *>(malloc(size + kHeaderSize));
+  if (p == NULL) {
+    return NULL;
+  }
+  memcpy(p, &size, sizeof(size));
+  AllocTracker::RecordAllocation(size);
+  return p + kHeaderSize;
+}
+
+void operator delete(void *p) noexcept {
+  if (p == NULL) {
+    return;
+  }
+  char *block = static_cast<char *>(p) - kHeaderSize;
+  size_t size = 0;
+  memcpy(&size, block, sizeof(size));
+  AllocTracker::RecordFree(size);
+  free(block);
+}
+
+void operator delete(void *p, const nothrow_t&) noexcept {
+  operator delete(p);
+}
+
+/******************************************************************************
+ * Function 'Begin'.
+ * Start counting for a phase.
+ *
+ * Parameters:
+ *   name - the name of the phase
+**/
+void AllocTracker::Begin(const string& name) {
+  int which = 0;
+  while (which < how_many_phases &&
+         strncmp(phases[which].name, name.c_str(), kMaxName - 1) != 0) {
+    ++which;
+  }
+  if (which == how_many_phases) {
+    if (how_many_phases == kMaxPhases) {
+      which = kMaxPhases - 1;
+    } else {
+      memset(&phases[which], 0, sizeof(phases[which]));
+      strncpy(phases[which].name, name.c_str(), kMaxName - 1);
+      ++how_many_phases;
+    }
+  }
+
+  int level = depth.load();
+  if (level < kMaxDepth) {
+    open_phases[level].which = which;
+    open_phases[level].allocations = total_allocations.load();
+    open_phases[level].bytes = total_bytes.load();
+    open_phases[level].peak_live = live_bytes.load();
+  }
+  depth.store(level + 1);
+}
+
+/******************************************************************************
+ * Function 'End'.
+ * Stop counting for the innermost open phase and add its counts to the
+ * totals for its name.
+**/
+void AllocTracker::End() {
+  int level = depth.load() - 1;
+  if (level < 0) {
+    return;
+  }
+  depth.store(level);
+  if (level >= kMaxDepth) {
+    return;
+  }
+
+  OpenPhase& open = open_phases[level];
+  PhaseTotals& totals = phases[open.which];
+  totals.calls += 1;
+  totals.allocations += total_allocations.load() - open.allocations;
+  totals.bytes += total_bytes.load() - open.bytes;
+  if (open.peak_live > totals.peak_live) {
+    totals.peak_live = open.peak_live;
+  }
+  if (level > 0 && open.peak_live > open_phases[level - 1].peak_live) {
+    open_phases[level - 1].peak_live = open.peak_live;
+  }
+}
+
+/******************************************************************************
+ * Function 'HowManyAllocations'.
+ * The number of allocations since the program started.
+**/
+uint64_t AllocTracker::HowManyAllocations() {
+  return total_allocations.load();
+}
+
+/******************************************************************************
+ * Function 'RecordAllocation'.
+ * Count one allocation.
+**/
+void AllocTracker::RecordAllocation(size_t size) {
+  total_allocations.fetch_add(1, memory_order_relaxed);
+  total_bytes.fetch_add(size, memory_order_relaxed);
+  uint64_t live = live_bytes.fetch_add(size, memory_order_relaxed) + size;
+
+  uint64_t peak = peak_live_bytes.load(memory_order_relaxed);
+  while (live > peak &&
+         !peak_live_bytes.compare_exchange_weak(peak, live,
+                                                memory_order_relaxed)) {
+  }
+
+  int level = depth.load(memory_order_relaxed);
+  if (level > 0 && level <= kMaxDepth &&
+      live > open_phases[level - 1].peak_live) {
+    open_phases[level - 1].peak_live = live;
+  }
+}
+
+/******************************************************************************
+ * Function 'RecordFree'.
+ * Count one free.
+**/
+void AllocTracker::RecordFree(size_t size) {
+  live_bytes.fetch_sub(size, memory_order_relaxed);
+}
+
+/******************************************************************************
+ * Function 'Summary'.
+ * Format the counts for each phase and for the whole run.
+**/
+string AllocTracker::Summary() {
+  string s = "ALLOCATIONS BY PHASE\n";
+  s += "PHASE                CALLS     ALLOCS        BYTES    PEAK LIVE\n";
+  for (int i = 0; i < how_many_phases; ++i) {
+    string name = phases[i].name;
+    if (name.length() < 18) {
+      name += string(18 - name.length(), ' ');
+    }
+    s += name + Utils::Format(static_cast<LONG>(phases[i].calls), 7)
+       + Utils::Format(static_cast<LONG>(phases[i].allocations), 11)
+       + Utils::Format(static_cast<LONG>(phases[i].bytes), 13)
+       + Utils::Format(static_cast<LONG>(phases[i].peak_live), 13) + "\n";
+  }
+  s += "WHOLE RUN         " + string(7, ' ')
+     + Utils::Format(static_cast<LONG>(total_allocations.load()), 11)
+     + Utils::Format(static_cast<LONG>(total_bytes.load()), 13)
+     + Utils::Format(static_cast<LONG>(peak_live_bytes.load()), 13) + "\n";
+  return s;
+}
+
+#endif // ALLOCTRACK
@@ -0,0 +1,36 @@
+/****************************************************************
+ * Header file for the 'AllocTracker' class, which counts the memory
+ * allocations made in each phase of an assembly.
+ *
+ * The tracker replaces the global 'operator new' and 'operator delete'
+ * and is compiled only when 'ALLOCTRACK' is defined, for example with
+ *   make GPP="g++ -O3 -Wall -std=c++11 -DALLOCTRACK"
+ * Otherwise 'alloctracker.cc' compiles to nothing and none of these
+ * functions may be called.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef ALLOCTRACKER_H
+#define ALLOCTRACKER_H
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+using namespace std;
+
+class AllocTracker {
+  public:
+    static void Begin(const string& name);
+    static void End();
+    static uint64_t HowManyAllocations();
+    static string Summary();
+
+    static void RecordAllocation(size_t size);
+    static void RecordFree(size_t size);
+};
+
+#endif
@@ -0,0 +1,354 @@
+#include "assemblycache.h"
+
+#include <algorithm>
+#include <ctime>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'AssemblyCache' for reusing the results of earlier assemblies.
+ *
+ * An entry is named by the hash of the assembler version and the source
+ * bytes, and holds the source itself, the '.bin' image, the listing, and
+ * the object file if one was written. The hash only picks the file; a hit
+ * needs the stored source to match byte for byte, so two sources that
+ * collide can never be given each other's results. Each entry is a single
+ * file written under a temporary name and renamed into place, so processes
+ * sharing a directory never see a partial entry. A hit touches the entry;
+ * when the directory grows past its cap the least recently used entries
+ * are removed, along with temporary files that a process which died in
+ * the middle of a store left behind.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "AssemblyCache: ";
+static const string kEntryMagic = "P16D";
+static const string kEntrySuffix = ".p16c";
+static const string kTempSuffix = ".tmp";
+static const time_t kStaleSeconds = 60;
+
+/******************************************************************************
+ * Constructor
+ *
+ * Parameters:
+ *   directory - the cache directory, created if need be
+ *   max_bytes - the cap on the total size of the entries
+**/
+AssemblyCache::AssemblyCache(string directory, long max_bytes) {
+  globals_ = Globals();
+  directory_ = directory;
+  max_bytes_ = max_bytes;
+  mkdir(directory_.c_str(), 0777);
+}
+
+/******************************************************************************
+ * Destructor
+**/
+AssemblyCache::~AssemblyCache() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'EntryName'.
+ * The file name of the entry for a source text.
+ *
+ * Parameters:
+ *   source - the bytes of the source file
+**/
+string AssemblyCache::EntryName(const string& source) const {
+  static const char kHexDigits[] = "0123456789abcdef";
+
+  uint64_t hash = globals_.HashBytes(Globals::kAssemblerVersion);
+  hash = globals_.HashBytes(source, hash);
+
+  string name = directory_ + "/";
+  for (int shift = 60; shift >= 0; shift -= 4) {
+    name += kHexDigits[(hash >> shift) & 0xF];
+  }
+  return name + kEntrySuffix;
+}
+
+/******************************************************************************
+ * Function 'Evict'.
+ * Remove the least recently used entries until the cache fits its cap,
+ * and any temporary file old enough that no store can still be writing it.
+**/
+void AssemblyCache::Evict() {
+  DIR *dir = opendir(directory_.c_str());
+  if (dir == NULL) {
+    return;
+  }
+
+  vector<pair<time_t, pair<long, string> > > entries;
+  long total_bytes = 0;
+  time_t now = time(NULL);
+  struct dirent *dirent;
+  while ((dirent = readdir(dir)) != NULL) {
+    string name = dirent->d_name;
+    size_t temp_at = name.find(kEntrySuffix + kTempSuffix);
+    if (temp_at != string::npos) {
+      string path = directory_ + "/" + name;
+      struct stat temp_stat;
+      if (stat(path.c_str(), &temp_stat) == 0 &&
+          now - temp_stat.st_mtime > kStaleSeconds &&
+          unlink(path.c_str()) == 0) {
+        Utils::log_stream << kTag << "removed stale '" << path << "'\n";
+      }
+      continue;
+    }
+    if (name.length() <= kEntrySuffix.length() ||
+        name.compare(name.length() - kEntrySuffix.length(),
+                     kEntrySuffix.length(), kEntrySuffix) != 0) {
+      continue;
+    }
+    string path = directory_ + "/" + name;
+    struct stat entry_stat;
+    if (stat(path.c_str(), &entry_stat) == 0) {
+      total_bytes += entry_stat.st_size;
+      entries.push_back(make_pair(entry_stat.st_mtime,
+                                  make_pair(entry_stat.st_size, path)));
+    }
+  }
+  closedir(dir);
+
+  if (total_bytes <= max_bytes_) {
+    return;
+  }
+
+  sort(entries.begin(), entries.end());
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if (total_bytes <= max_bytes_) {
+      break;
+    }
+    if (unlink(it->second.second.c_str()) == 0) {
+      total_bytes -= it->second.first;
+      Utils::log_stream << kTag << "evicted '" << it->second.second << "'\n";
+    }
+  }
+}
+
+/******************************************************************************
+ * Function 'Fetch'.
+ * Look up a source text and on a hit write out its results.
+ *
+ * Parameters:
+ *   source - the bytes of the source file
+ *   binary_filename - the '.bin' file to write
+ *   object_filename - the object file to write, or empty if none wanted
+ *   out_stream - the stream to write the listing to
+ *
+ * Returns:
+ *   true on a hit, in which case no assembly is needed
+**/
+bool AssemblyCache::Fetch(const string& source, string binary_filename,
+                          string object_filename, ofstream& out_stream) {
+#ifdef EBUG
+  Utils::log_stream << "enter Fetch\n";
+#endif
+
+  if (this->HasInclude(source)) {
+    Utils::log_stream << kTag << "not cached, the source has includes\n";
+    return false;
+  }
+
+  string name = this->EntryName(source);
+  string entry = "";
+  if (!this->ReadFile(name, entry)) {
+    Utils::log_stream << kTag << "miss '" << name << "'\n";
+    return false;
+  }
+
+  // header: magic, then the source, binary, listing and object sizes;
+  // the bytes of each follow in that order
+  size_t header_length = kEntryMagic.length() + 4 * sizeof(uint64_t);
+  if (entry.length() < header_length ||
+      entry.compare(0, kEntryMagic.length(), kEntryMagic) != 0) {
+    return false;
+  }
+  uint64_t sizes[4];
+  entry.copy(reinterpret_cast<char *>(sizes), sizeof(sizes),
+             kEntryMagic.length());
+  if (sizes[0] != source.length() ||
+      entry.length() != header_length + sizes[0] + sizes[1] + sizes[2] +
+                        sizes[3] ||
+      entry.compare(header_length, sizes[0], source) != 0) {
+    Utils::log_stream << kTag << "miss '" << name << "', another source\n";
+    return false;
+  }
+  if (object_filename != "" && sizes[3] == 0) {
+    return false;
+  }
+
+  size_t offset = header_length + sizes[0];
+  if (!this->WriteFile(binary_filename, entry.substr(offset, sizes[1]))) {
+    return false;
+  }
+  offset += sizes[1];
+  out_stream.write(entry.data() + offset, sizes[2]);
+  offset += sizes[2];
+  if (object_filename != "" &&
+      !this->WriteFile(object_filename, entry.substr(offset, sizes[3]))) {
+    return false;
+  }
+
+  // touch the entry so that it is the most recently used
+  utimes(name.c_str(), NULL);
+  Utils::log_stream << kTag << "hit '" << name << "'\n";
+
+#ifdef EBUG
+  Utils::log_stream << "leave Fetch\n";
+#endif
+  return true;
+}
+
+/******************************************************************************
+ * Function 'HasInclude'.
+ * Whether the source has an 'INC' line. The key covers only the main
+ * source, so such programs are never cached.
+ *
+ * Parameters:
+ *   source - the bytes of the source file
+**/
+bool AssemblyCache::HasInclude(const string& source) const {
+  size_t start = 0;
+  while (start < source.length()) {
+    if (start + 7 <= source.length() && source[start] != '*' &&
+        source.compare(start + 4, 3, "INC") == 0) {
+      return true;
+    }
+    size_t newline = source.find('\n', start);
+    if (newline == string::npos) {
+      break;
+    }
+    start = newline + 1;
+  }
+  return false;
+}
+
+/******************************************************************************
+ * Function 'ReadFile'.
+ * Read a whole file into a string.
+ *
+ * Parameters:
+ *   filename - the file to read
+ *   contents - the string to read into
+ *
+ * Returns:
+ *   true if the file could be read
+**/
+bool AssemblyCache::ReadFile(string filename, string& contents) const {
+  FILE *fp = fopen(filename.c_str(), "r");
+  if (fp == NULL) {
+    return false;
+  }
+
+  struct stat file_stat;
+  if (fstat(fileno(fp), &file_stat) != 0) {
+    fclose(fp);
+    return false;
+  }
+
+  contents.resize(file_stat.st_size);
+  size_t how_many = 0;
+  if (file_stat.st_size > 0) {
+    how_many = fread(&contents[0], 1, file_stat.st_size, fp);
+  }
+  fclose(fp);
+
+  return how_many == contents.length();
+}
+
+/******************************************************************************
+ * Function 'Store'.
+ * Add the results of an assembly to the cache.
+ *
+ * Parameters:
+ *   source - the bytes of the source file
+ *   binary_filename - the '.bin' file that was written
+ *   object_filename - the object file that was written, or empty
+ *   out_filename - the listing file that was written
+**/
+void AssemblyCache::Store(const string& source, string binary_filename,
+                          string object_filename, string out_filename) {
+#ifdef EBUG
+  Utils::log_stream << "enter Store\n";
+#endif
+
+  if (this->HasInclude(source)) {
+    return;
+  }
+
+  string binary = "";
+  string listing = "";
+  string object = "";
+  if (!this->ReadFile(binary_filename, binary) ||
+      !this->ReadFile(out_filename, listing)) {
+    return;
+  }
+  if (object_filename != "") {
+    this->ReadFile(object_filename, object);
+  }
+
+  uint64_t sizes[4] = { source.length(), binary.length(),
+                        listing.length(), object.length() };
+  string entry = kEntryMagic;
+  entry.append(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+  entry += source;
+  entry += binary;
+  entry += listing;
+  entry += object;
+
+  string name = this->EntryName(source);
+  string temp_name = name + kTempSuffix +
+                     Utils::Format(static_cast<int>(getpid()));
+  if (this->WriteFile(temp_name, entry) &&
+      rename(temp_name.c_str(), name.c_str()) == 0) {
+    Utils::log_stream << kTag << "stored '" << name << "'\n";
+  } else {
+    unlink(temp_name.c_str());
+  }
+
+  this->Evict();
+
+#ifdef EBUG
+  Utils::log_stream << "leave Store\n";
+#endif
+}
+
+/******************************************************************************
+ * Function 'WriteFile'.
+ * Write a string to a file.
+ *
+ * Parameters:
+ *   filename - the file to write
+ *   contents - the bytes to write
+ *
+ * Returns:
+ *   true if all of the bytes were written
+**/
+bool AssemblyCache::WriteFile(string filename, const string& contents) const {
+  FILE *fp = fopen(filename.c_str(), "w");
+  if (fp == NULL) {
+    return false;
+  }
+
+  size_t how_many = fwrite(contents.data(), 1, contents.length(), fp);
+  bool closed = (fclose(fp) == 0);
+
+  return closed && (how_many == contents.length());
+}
@@ -0,0 +1,46 @@
+/****************************************************************
+ * Header file for the 'AssemblyCache' class, an on-disk cache of
+ * assembler results keyed on the source text.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef ASSEMBLYCACHE_H
+#define ASSEMBLYCACHE_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+using namespace std;
+
+#include "../../Utilities/utils.h"
+
+#include "globals.h"
+
+class AssemblyCache {
+  public:
+    AssemblyCache(string directory, long max_bytes);
+    virtual ~AssemblyCache();
+
+    bool Fetch(const string& source, string binary_filename,
+               string object_filename, ofstream& out_stream);
+    bool ReadFile(string filename, string& contents) const;
+    void Store(const string& source, string binary_filename,
+               string object_filename, string out_filename);
+
+  private:
+    string directory_;
+    long max_bytes_;
+
+    Globals globals_;
+
+    void Evict();
+    string EntryName(const string& source) const;
+    bool HasInclude(const string& source) const;
+    bool WriteFile(string filename, const string& contents) const;
+};
+
+#endif
@@ -0,0 +1,518 @@
+#include "bench.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'AssemblerBench' for timing the stages of the assembler.
+ *
+ * A synthetic program is made by 'CorpusGenerator' from a seed, so that
+ * runs with the same settings assemble exactly the same source. Each stage is run
+ * 'how_many_reps' times and the fastest run is kept. All figures are per
+ * source line, including the stages that only see some of the lines.
+ *
+ * Allocations are counted by replacing the global 'operator new' in this
+ * file, which is linked only into the benchmark program.
+ *
+ * 'PassOne' is timed as a whole, so it includes its own 'NextLine' calls
+ * and the listing it prints through 'CodeLine::ToString'. The field
+ * slicing it does for each line is also timed alone, as 'ParseCodeLine'
+ * over lines already read and padded.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "AssemblerBench: ";
+static const string kCorpusFilename = "bench_corpus.txt";
+static const string kListingFilename = "bench_listing.txt";
+static const string kBinaryFilename = "bench_binary.bin";
+
+/******************************************************************************
+ * The counting replacements for the global allocation functions. In an
+ * 'ALLOCTRACK' build the tracker owns them, and its count is used.
+**/
+#ifdef ALLOCTRACK
+#define allocation_count AllocTracker::HowManyAllocations()
+#else
+static uint64_t allocation_count = 0;
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  void *p = malloc(size == 0 ? 1 : size);
+  if (p == NULL) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+#endif
+
+/******************************************************************************
+ * The current time in nanoseconds.
+**/
+static uint64_t NowNs() {
+  return chrono::duration_cast<chrono::nanoseconds>(
+           chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/******************************************************************************
+ * Constructor
+ *
+ * Parameters:
+ *   how_many_lines - the number of instruction lines in the corpus
+ *   how_many_reps - the number of times each stage is run
+ *   seed - the seed for generating the corpus
+**/
+AssemblerBench::AssemblerBench(int how_many_lines, int how_many_reps,
+                               uint64_t seed) {
+  globals_ = Globals();
+
+  // keep every PC inside memory, with room for the 'END'
+  how_many_lines_ = how_many_lines;
+  if (how_many_lines_ < 1) {
+    how_many_lines_ = 1;
+  }
+  if (how_many_lines_ > Globals::kMaxMemory - 1) {
+    how_many_lines_ = Globals::kMaxMemory - 1;
+  }
+  how_many_reps_ = (how_many_reps > 0) ? how_many_reps : 1;
+  seed_ = (seed != 0) ? seed : 1;
+}
+
+/******************************************************************************
+ * Destructor
+**/
+AssemblerBench::~AssemblerBench() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'Compare'.
+ * Compare the results against a baseline written by 'Save'. A stage has
+ * regressed if it is slower than the baseline by more than 'tolerance'
+ * percent or if it makes more allocations per line.
+ *
+ * Parameters:
+ *   baseline_filename - the baseline file
+ *   tolerance - the allowed slowdown in percent
+ *
+ * Returns:
+ *   the number of stages that regressed, or -1 if there is no baseline
+**/
+int AssemblerBench::Compare(string baseline_filename,
+                            double tolerance) const {
+  ifstream in_stream(baseline_filename.c_str());
+  if (in_stream.fail()) {
+    cout << kTag << "no baseline '" << baseline_filename << "'" << endl;
+    Utils::log_stream << kTag << "no baseline '" << baseline_filename
+                      << "'" << endl;
+    return -1;
+  }
+
+  vector<StageResult> baseline;
+  StageResult entry;
+  while (in_stream >> entry.name >> entry.ns_per_line
+                   >> entry.allocs_per_line) {
+    entry.bytes = 0;
+    baseline.push_back(entry);
+  }
+
+  int regressions = 0;
+  string s = "COMPARED WITH '" + baseline_filename + "'\n";
+  s += "STAGE                 BASELINE   CHANGE\n";
+  for (auto it = results_.begin(); it != results_.end(); ++it) {
+    for (auto base = baseline.begin(); base != baseline.end(); ++base) {
+      if (base->name != it->name || base->ns_per_line <= 0.0) {
+        continue;
+      }
+      double change = 100.0 * (it->ns_per_line - base->ns_per_line)
+                    / base->ns_per_line;
+      bool regressed = change > tolerance ||
+                       it->allocs_per_line > base->allocs_per_line + 0.005;
+      s += it->name + string(20 - it->name.length(), ' ')
+         + Utils::Format(base->ns_per_line, 10, 1)
+         + Utils::Format(change, 9, 1) + "%"
+         + (regressed ? "  REGRESSION" : "") + "\n";
+      if (regressed) {
+        ++regressions;
+      }
+    }
+  }
+
+  cout << s;
+  Utils::log_stream << s;
+  return regressions;
+}
+
+/******************************************************************************
+ * Function 'Record'.
+ * Save the figures for one stage.
+ *
+ * Parameters:
+ *   name - the stage
+ *   best_ns - the time of the fastest run
+ *   allocations - the allocations made in one run
+ *   bytes - the bytes written in one run
+**/
+void AssemblerBench::Record(string name, uint64_t best_ns,
+                            uint64_t allocations, long bytes) {
+  StageResult result;
+  result.name = name;
+  result.ns_per_line = static_cast<double>(best_ns) / how_many_lines_;
+  result.allocs_per_line = static_cast<double>(allocations) / how_many_lines_;
+  result.bytes = bytes;
+  results_.push_back(result);
+}
+
+/******************************************************************************
+ * Function 'Report'.
+ * Format the results as a table.
+**/
+string AssemblerBench::Report() const {
+  string s = "BENCHMARK " + Utils::Format(how_many_lines_) + " LINES, "
+           + Utils::Format(how_many_reps_) + " REPS\n";
+  s += "STAGE                  NS/LINE  ALLOCS/LINE       BYTES\n";
+  for (auto it = results_.begin(); it != results_.end(); ++it) {
+    s += it->name + string(20 - it->name.length(), ' ')
+       + Utils::Format(it->ns_per_line, 10, 1)
+       + Utils::Format(it->allocs_per_line, 13, 2)
+       + Utils::Format(static_cast<LONG>(it->bytes), 12) + "\n";
+  }
+  return s;
+}
+
+/******************************************************************************
+ * Function 'Run'.
+ * This top level function writes the corpus and times every stage. The
+ * assembler echoes to standard output as it goes, so that is discarded
+ * while the stages run.
+**/
+void AssemblerBench::Run() {
+#ifdef EBUG
+  Utils::log_stream << "enter Run\n";
+#endif
+
+  CorpusGenerator generator(seed_);
+  string source = generator.Generate(how_many_lines_);
+  FILE *fp = fopen(kCorpusFilename.c_str(), "w");
+  if (fp == NULL) {
+    cout << kTag << "cannot write '" << kCorpusFilename << "'" << endl;
+    return;
+  }
+  fwrite(source.data(), 1, source.size(), fp);
+  fclose(fp);
+
+  ofstream null_stream("/dev/null");
+  streambuf *cout_buffer = cout.rdbuf(null_stream.rdbuf());
+
+  results_.clear();
+  assembler_.ValidMnemonics();
+  this->TimeNextLine();
+  this->TimeParseCodeLine();
+  this->TimePassOne();
+  this->TimeParseHexOperand();
+  this->TimeFindAddress();
+  this->TimePassTwo();
+  this->TimeToString();
+  this->TimeWriteBinaryFile();
+
+  cout.rdbuf(cout_buffer);
+
+  unlink(kCorpusFilename.c_str());
+  unlink(kListingFilename.c_str());
+  unlink(kBinaryFilename.c_str());
+
+#ifdef EBUG
+  Utils::log_stream << "leave Run\n";
+#endif
+}
+
+/******************************************************************************
+ * Function 'Save'.
+ * Write the results as a baseline for 'Compare'.
+ *
+ * Returns:
+ *   true if the file was written
+**/
+bool AssemblerBench::Save(string baseline_filename) const {
+  ofstream out_stream(baseline_filename.c_str());
+  if (out_stream.fail()) {
+    return false;
+  }
+  for (auto it = results_.begin(); it != results_.end(); ++it) {
+    out_stream << it->name << " " << it->ns_per_line << " "
+               << it->allocs_per_line << "\n";
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Function 'TimeFindAddress'.
+ * Time 'FindAddress' over the Format I lines left by pass one.
+**/
+void AssemblerBench::TimeFindAddress() {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+  long bytes = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    bytes = 0;
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    for (auto it = assembler_.codelines_.begin();
+         it != assembler_.codelines_.end(); ++it) {
+      if (globals_.MnemonicToOpcode(it->GetMnemonic()) >= 0) {
+        bytes += assembler_.FindAddress(it->GetAddr(),
+                                        it->GetSymOperand()).length();
+      }
+    }
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+  }
+
+  this->Record("FindAddress", best_ns, allocations, bytes);
+}
+
+/******************************************************************************
+ * Function 'TimeNextLine'.
+ * Time 'Scanner::NextLine' reading the corpus file.
+**/
+void AssemblerBench::TimeNextLine() {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+  long bytes = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    Scanner in_scanner;
+    in_scanner.OpenFile(kCorpusFilename);
+
+    bytes = 0;
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    string line = in_scanner.NextLine();
+    while (line.length() > 0) {
+      bytes += line.length();
+      line = in_scanner.NextLine();
+    }
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+
+    in_scanner.Close();
+  }
+
+  this->Record("Scanner::NextLine", best_ns, allocations, bytes);
+}
+
+/******************************************************************************
+ * Function 'TimeParseCodeLine'.
+ * Time the slicing of each source line into its fields, which pass one
+ * does through 'ParseCodeLine'. The lines are read and padded first, and
+ * comment-only lines, which pass one does not slice, are left out.
+**/
+void AssemblerBench::TimeParseCodeLine() {
+  vector<string> lines;
+  Scanner in_scanner;
+  in_scanner.OpenFile(kCorpusFilename);
+  string line = in_scanner.NextLine();
+  while (line.length() > 0) {
+    if (line.substr(0, 1) != "*") {
+      line.resize(80, ' ');
+      lines.push_back(line);
+    }
+    line = in_scanner.NextLine();
+  }
+  in_scanner.Close();
+
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+  long bytes = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    assembler_.Reset();
+
+    bytes = 0;
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    for (size_t i = 0; i < lines.size(); ++i) {
+      CodeLine code_line = assembler_.ParseCodeLine(lines[i], i);
+      bytes += code_line.GetComments().length();
+    }
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+  }
+
+  this->Record("ParseCodeLine", best_ns, allocations, bytes);
+}
+
+/******************************************************************************
+ * Function 'TimeParseHexOperand'.
+ * Time the parsing of every hex operand field, which is done by the
+ * 'Hex' constructor.
+**/
+void AssemblerBench::TimeParseHexOperand() {
+  vector<string> hexoperands;
+  for (auto it = assembler_.codelines_.begin();
+       it != assembler_.codelines_.end(); ++it) {
+    hexoperands.push_back(it->GetHexObject().GetText());
+  }
+
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+  long sum = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    for (auto it = hexoperands.begin(); it != hexoperands.end(); ++it) {
+      Hex hex(*it, globals_);
+      sum += hex.GetValue();
+    }
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+  }
+
+  Utils::log_stream << kTag << "hex checksum " << sum << endl;
+  this->Record("Hex::ParseHexOperand", best_ns, allocations, 0);
+}
+
+/******************************************************************************
+ * Function 'TimePassOne'.
+ * Time pass one over the corpus file, writing the listing to a file.
+**/
+void AssemblerBench::TimePassOne() {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+  long bytes = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    Scanner in_scanner;
+    ofstream out_stream;
+    in_scanner.OpenFile(kCorpusFilename);
+    Utils::FileOpen(out_stream, kListingFilename);
+    assembler_.Reset();
+
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    assembler_.PassOne(in_scanner, out_stream);
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+
+    bytes = out_stream.tellp();
+    in_scanner.Close();
+    Utils::FileClose(out_stream);
+  }
+
+  this->Record("PassOne", best_ns, allocations, bytes);
+}
+
+/******************************************************************************
+ * Function 'TimePassTwo'.
+ * Time pass two over the lines left by pass one.
+**/
+void AssemblerBench::TimePassTwo() {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    assembler_.machinecode_.clear();
+
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    assembler_.PassTwo();
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+  }
+
+  this->Record("PassTwo", best_ns, allocations, 0);
+}
+
+/******************************************************************************
+ * Function 'TimeToString'.
+ * Time 'CodeLine::ToString' over the lines left by pass one.
+**/
+void AssemblerBench::TimeToString() {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+  long bytes = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    bytes = 0;
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    for (auto it = assembler_.codelines_.begin();
+         it != assembler_.codelines_.end(); ++it) {
+      bytes += it->ToString().length();
+    }
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+  }
+
+  this->Record("CodeLine::ToString", best_ns, allocations, bytes);
+}
+
+/******************************************************************************
+ * Function 'TimeWriteBinaryFile'.
+ * Time writing the '.bin' image left by pass two.
+**/
+void AssemblerBench::TimeWriteBinaryFile() {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t allocations = 0;
+
+  for (int rep = 0; rep < how_many_reps_; ++rep) {
+    uint64_t allocations_before = allocation_count;
+    uint64_t start = NowNs();
+    assembler_.WriteBinaryFile(kBinaryFilename);
+    uint64_t elapsed = NowNs() - start;
+    allocations = allocation_count - allocations_before;
+    if (elapsed < best_ns) {
+      best_ns = elapsed;
+    }
+  }
+
+  struct stat file_stat;
+  long bytes = 0;
+  if (stat(kBinaryFilename.c_str(), &file_stat) == 0) {
+    bytes = file_stat.st_size;
+  }
+
+  this->Record("WriteBinaryFile", best_ns, allocations, bytes);
+}
@@ -0,0 +1,68 @@
+/****************************************************************
+ * Header file for the 'AssemblerBench' class, the micro-benchmark
+ * harness for the stages of the assembler.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+#include "../../Utilities/scanner.h"
+#include "../../Utilities/utils.h"
+
+#include "globals.h"
+#include "codeline.h"
+#include "generator.h"
+#include "hex.h"
+#include "pullet16assembler.h"
+
+class AssemblerBench {
+  public:
+    AssemblerBench(int how_many_lines, int how_many_reps, uint64_t seed);
+    virtual ~AssemblerBench();
+
+    int Compare(string baseline_filename, double tolerance) const;
+    string Report() const;
+    void Run();
+    bool Save(string baseline_filename) const;
+
+  private:
+    struct StageResult {
+      string name;
+      double ns_per_line;
+      double allocs_per_line;
+      long bytes;
+    };
+
+    int how_many_lines_;
+    int how_many_reps_;
+    uint64_t seed_;
+    vector<StageResult> results_;
+
+    Assembler assembler_;
+    Globals globals_;
+
+    void Record(string name, uint64_t best_ns, uint64_t allocations,
+                long bytes);
+    void TimeFindAddress();
+    void TimeNextLine();
+    void TimeParseCodeLine();
+    void TimeParseHexOperand();
+    void TimePassOne();
+    void TimePassTwo();
+    void TimeToString();
+    void TimeWriteBinaryFile();
+};
+
+#endif
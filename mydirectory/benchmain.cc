@@ -0,0 +1,99 @@
+#include "bench.h"
+
+/****************************************************************
+ * Main program for the Pullet assembler benchmarks.
+ *
+ * Author/copyright:  Duncan Buell. All rights reserved.
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+ * Note that all file names are entered without extensions.
+ *
+ * Options may follow the log file name:
+ *   -lines n  generate a program of 'n' lines (default 2000)
+ *   -reps n  run each stage 'n' times and keep the fastest (default 20)
+ *   -seed n  seed for generating the program (default 1)
+ *   -baseline name  compare against the baseline 'name.txt'
+ *   -save name  save the results as the baseline 'name.txt'
+ *   -tolerance pct  allowed slowdown against the baseline (default 10)
+ *
+ * The exit status is 1 if any stage regressed against the baseline, or
+ * if a baseline was named and cannot be read; 'make benchbaseline'
+ * writes the one that 'make bench' compares against.
+**/
+
+static const string kTag = "BenchMain: ";
+static const string kUsage = "logfilename [-lines n] [-reps n] [-seed n]"
+                             " [-baseline name] [-save name]"
+                             " [-tolerance pct]";
+
+/****************************************************************
+ * Print the usage message and stop.
+**/
+static void Usage(char *argv[]) {
+  cout << kTag << "usage: " << argv[0] << " " << kUsage << endl;
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  string log_filename = "";
+  string baseline_filename = "";
+  string save_filename = "";
+  int how_many_lines = 2000;
+  int how_many_reps = 20;
+  LONG seed = 1;
+  int tolerance = 10;
+
+  if (argc < 2) {
+    Usage(argv);
+  }
+  log_filename = static_cast<string>(argv[1]) + ".txt";
+
+  for (int i = 2; i < argc; ++i) {
+    string option = static_cast<string>(argv[i]);
+    if (i + 1 >= argc) {
+      Usage(argv);
+    } else if (option == "-lines") {
+      how_many_lines = Utils::StringToInteger(static_cast<string>(argv[++i]));
+    } else if (option == "-reps") {
+      how_many_reps = Utils::StringToInteger(static_cast<string>(argv[++i]));
+    } else if (option == "-seed") {
+      seed = Utils::StringToLONG(static_cast<string>(argv[++i]));
+    } else if (option == "-baseline") {
+      baseline_filename = static_cast<string>(argv[++i]) + ".txt";
+    } else if (option == "-save") {
+      save_filename = static_cast<string>(argv[++i]) + ".txt";
+    } else if (option == "-tolerance") {
+      tolerance = Utils::StringToInteger(static_cast<string>(argv[++i]));
+    } else {
+      Usage(argv);
+    }
+  }
+
+  Utils::LogFileOpen(log_filename);
+
+  Utils::log_stream << kTag << "Beginning execution\n";
+  Utils::log_stream.flush();
+
+  AssemblerBench bench(how_many_lines, how_many_reps, seed);
+  bench.Run();
+
+  string report = bench.Report();
+  cout << report;
+  Utils::log_stream << report;
+
+  int regressions = 0;
+  if (baseline_filename != "") {
+    regressions = bench.Compare(baseline_filename, tolerance);
+  }
+  if (save_filename != "" && !bench.Save(save_filename)) {
+    cout << kTag << "cannot write '" << save_filename << "'" << endl;
+  }
+
+  Utils::log_stream << kTag << "Ending execution\n";
+  Utils::log_stream.flush();
+
+  Utils::FileClose(Utils::log_stream);
+
+  return (regressions != 0) ? 1 : 0;
+}
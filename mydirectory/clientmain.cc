@@ -0,0 +1,112 @@
+#include "daemon.h"
+
+/****************************************************************
+ * Main program for the Pullet assembler daemon client.
+ *
+ * Author/copyright:  Duncan Buell. All rights reserved.
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+ * Note that all file names are entered without extensions.
+ *
+ * This takes the same arguments as 'Aprog' and writes the same
+ * listing, '.bin', and '.obj' files, but the assembling is done by a
+ * running daemon. The daemon's own log records the assembly.
+ *
+ * Options may follow the three file names:
+ *   -obj  also write a relocatable object file 'outfilename.obj'
+ *   -socket name  talk to the daemon on 'name' (default /tmp/pullet16.sock)
+**/
+
+static const string kTag = "ClientMain: ";
+static const string kUsage = "infilename outfilename logfilename [-obj]"
+                             " [-socket name]";
+
+/****************************************************************
+ * Print the usage message and stop.
+**/
+static void Usage(char *argv[]) {
+  cout << kTag << "usage: " << argv[0] << " " << kUsage << endl;
+  exit(1);
+}
+
+/****************************************************************
+ * Write a string to a file.
+**/
+static void WriteFile(string filename, const string& contents) {
+  ofstream out_stream;
+  Utils::FileOpen(out_stream, filename);
+  out_stream.write(contents.data(), contents.size());
+  Utils::FileClose(out_stream);
+}
+
+int main(int argc, char *argv[]) {
+  string in_filename = "";
+  string binary_filename = "";
+  string object_filename = "";
+  string out_filename = "";
+  string log_filename = "";
+  string socket_name = AssemblerDaemon::kDefaultSocket;
+
+  if (argc < 4) {
+    Usage(argv);
+  }
+  in_filename = static_cast<string>(argv[1]) + ".txt";
+  binary_filename = static_cast<string>(argv[2]) + ".bin";
+  out_filename = static_cast<string>(argv[2]) + ".txt";
+  log_filename = static_cast<string>(argv[3]) + ".txt";
+
+  for (int i = 4; i < argc; ++i) {
+    string option = static_cast<string>(argv[i]);
+    if (option == "-obj") {
+      object_filename = static_cast<string>(argv[2]) + ".obj";
+    } else if (option == "-socket" && i + 1 < argc) {
+      socket_name = static_cast<string>(argv[++i]);
+    } else {
+      Usage(argv);
+    }
+  }
+
+  Utils::LogFileOpen(log_filename);
+
+  Utils::log_stream << kTag << "Beginning execution\n";
+  Utils::log_stream.flush();
+
+  ifstream in_stream;
+  Utils::FileOpen(in_stream, in_filename);
+  string source((istreambuf_iterator<char>(in_stream)),
+                istreambuf_iterator<char>());
+  Utils::FileClose(in_stream);
+
+  string listing = "";
+  string binary = "";
+  string object = "";
+  string error = "";
+  bool answered = AssemblerDaemon::Request(socket_name, source,
+                                           object_filename != "",
+                                           listing, binary, object, error);
+  if (answered) {
+    WriteFile(out_filename, listing);
+    WriteFile(binary_filename, binary);
+    if (object_filename != "" && object != "") {
+      WriteFile(object_filename, object);
+    }
+  } else if (error != "") {
+    Utils::log_stream << kTag << "the daemon could not assemble '"
+                      << in_filename << "': " << error << endl;
+    cout << kTag << "the daemon could not assemble '"
+         << in_filename << "': " << error << endl;
+  } else {
+    Utils::log_stream << kTag << "no answer from the daemon on '"
+                      << socket_name << "'" << endl;
+    cout << kTag << "no answer from the daemon on '"
+         << socket_name << "'" << endl;
+  }
+
+  Utils::log_stream << kTag << "Ending execution\n";
+  Utils::log_stream.flush();
+
+  Utils::FileClose(Utils::log_stream);
+
+  return answered ? 0 : 1;
+}
@@ -13,10 +13,12 @@
  * Constructor
 **/
 CodeLine::CodeLine() {
+  has_expression_ = false;
 }
 
 CodeLine::CodeLine(Globals globals) {
   globals_ = globals;
+  has_expression_ = false;
 }
 
 /******************************************************************************
@@ -61,6 +63,14 @@ string CodeLine::GetErrorMessages() const {
   return error_messages_;
 }
 
+/******************************************************************************
+ * Accessor for the 'expression_'.
+**/
+const Expression& CodeLine::GetExpression() const {
+
+  return expression_;
+}
+
 /******************************************************************************
  * Accessor for the 'hex_'.
 **/
@@ -101,6 +111,14 @@ string CodeLine::GetSymOperand() const {
   return symoperand_;
 }
 
+/******************************************************************************
+ * Boolean indicator of the presence of an expression operand.
+**/
+bool CodeLine::HasExpression() const {
+
+  return has_expression_;
+}
+
 /******************************************************************************
  * Boolean indicator of the presence of a label.
 **/
@@ -165,6 +183,7 @@ void CodeLine::SetCodeLine(int linecounter, int pc, string label,
   hex_ = Hex(hexoperand_, globals_);
   this->comments_ = comments;
   this->code_ = code;
+  this->has_expression_ = false;
   this->is_all_comment_ = false;
 }
 
@@ -191,6 +210,19 @@ void CodeLine::SetErrorMessages(string messages) {
   error_messages_ = messages;
 }
 
+/******************************************************************************
+ * Function 'SetExpression'.
+ * Sets the expression that replaces the symbolic and hex operands.
+ *
+ * Parameters:
+ *   expression - the expression, parsed or evaluated
+**/
+void CodeLine::SetExpression(Expression expression) {
+
+  expression_ = expression;
+  has_expression_ = true;
+}
+
 /******************************************************************************
  * Function 'SetMachineCode'.
  * Set the 'code_' for this line of code.
@@ -260,16 +292,22 @@ string CodeLine::ToString() const
     s += " " + Utils::Format(" ", 1);
   }
 
-  if (symoperand_ == "nullsymoperand") {
-    s += " " + Utils::Format("...", 3);
+  if (has_expression_) {
+    s += " " + expression_.ToString();
+  } else if (symoperand_.substr(0, 1) == "=") {
+    s += " " + symoperand_ + string(9 - symoperand_.length(), ' ');
   } else {
-    s += " " + Utils::Format(symoperand_, 3);
-  }
+    if (symoperand_ == "nullsymoperand") {
+      s += " " + Utils::Format("...", 3);
+    } else {
+      s += " " + Utils::Format(symoperand_, 3);
+    }
 
-  if (hex_.IsNull()) {
-    s += " " + Utils::Format(".....", 5);
-  } else {
-    s += " " + hex_.ToString();
+    if (hex_.IsNull()) {
+      s += " " + Utils::Format(".....", 5);
+    } else {
+      s += " " + hex_.ToString();
+    }
   }
 
   if (comments_ != "nullcomments") {
@@ -18,6 +18,7 @@ using namespace std;
 #include "../../Utilities/utils.h"
 
 #include "globals.h"
+#include "expression.h"
 #include "hex.h"
 
 class CodeLine {
@@ -30,12 +31,14 @@ class CodeLine {
     string GetCode() const;
     string GetComments() const;
     string GetErrorMessages() const;
+    const Expression& GetExpression() const;
     Hex GetHexObject() const;
     string GetLabel() const;
     string GetMnemonic() const;
     int GetPC() const;
     string GetSymOperand() const;
 
+    bool HasExpression() const;
     bool HasLabel() const;
     bool HasSymOperand() const;
 
@@ -45,11 +48,13 @@ class CodeLine {
                      string comments, string code);
     void SetCommentsOnly(int linecounter, string line);
     void SetErrorMessages(string messages);
+    void SetExpression(Expression expression);
     void SetMachineCode(string code);
     void SetPC(int what);
     string ToString() const;
 
   private:
+    bool has_expression_;
     bool is_all_comment_;
 
     int linecounter_;
@@ -64,6 +69,7 @@ class CodeLine {
     string symoperand_;
     string hexoperand_; 
 
+    Expression expression_;
     Globals globals_;
     Hex hex_;
 };
@@ -0,0 +1,474 @@
+#include "daemon.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'AssemblerDaemon' for assembling without paying process startup.
+ *
+ * The daemon listens on a Unix domain socket and forks a pool of worker
+ * processes that all accept on it. Workers are processes rather than
+ * threads because the assembler logs through the static 'Utils' streams.
+ * Each worker keeps one 'Assembler', so the mnemonic table is built once
+ * per worker, and the parent starts a new worker if one dies.
+ *
+ * A request is the tag 'P16R', a 64-bit flag that asks for an object
+ * file, the source text, and the client's working directory, against
+ * which 'INC' file names are resolved. The reply is the tag 'P16A'
+ * followed by the listing, the '.bin' image, and the object file, which
+ * is empty if none was written. A request that cannot be assembled at
+ * all is answered with the tag 'P16E' and a message instead. Strings are
+ * sent as a 64-bit length and the bytes, in host order, since both ends
+ * are on the same machine.
+ *
+ * Nothing touches the disk: the source is scanned from memory and the
+ * listing and images are built in memory. The worker's log records one
+ * line per request rather than a copy of every listing.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "AssemblerDaemon: ";
+static const string kRequestMagic = "P16R";
+static const string kReplyMagic = "P16A";
+static const string kErrorMagic = "P16E";
+static const uint64_t kMaxMessage = 64 * 1024 * 1024;
+
+const string AssemblerDaemon::kDefaultSocket = "/tmp/pullet16.sock";
+
+static volatile sig_atomic_t stop_requested = 0;
+
+/******************************************************************************
+ * Signal handler that asks the daemon to shut down.
+**/
+static void RequestStop(int signal_number) {
+  stop_requested = 1;
+}
+
+/******************************************************************************
+ * Helper to pack a string as a length and the bytes.
+**/
+static void PutString(string& s, const string& value) {
+  uint64_t length = value.length();
+  s.append(reinterpret_cast<const char *>(&length), sizeof(length));
+  s += value;
+}
+
+/******************************************************************************
+ * Constructor
+ *
+ * Parameters:
+ *   socket_name - the path of the Unix domain socket
+ *   how_many_workers - the number of worker processes to run
+**/
+AssemblerDaemon::AssemblerDaemon(string socket_name, int how_many_workers) {
+  socket_name_ = socket_name;
+  how_many_workers_ = (how_many_workers > 0) ? how_many_workers : 1;
+}
+
+/******************************************************************************
+ * Destructor
+**/
+AssemblerDaemon::~AssemblerDaemon() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'AssembleSource'.
+ * Assemble one source text with the worker's resident assembler,
+ * entirely in memory. The assembler's own logging is switched off for
+ * the duration, since it would copy every listing into the worker's log.
+ *
+ * Parameters:
+ *   source - the bytes of the source file
+ *   directory - the client's working directory, for 'INC' files
+ *   want_object - whether to build an object file as well
+ *   listing - the listing that 'Aprog' would write
+ *   binary - the '.bin' image
+ *   object - the object file, empty if none was built
+ *
+ * Returns:
+ *   false, with a message in 'listing', if the source was not assembled
+**/
+bool AssemblerDaemon::AssembleSource(const string& source,
+                                     const string& directory,
+                                     bool want_object, string& listing,
+                                     string& binary, string& object) {
+#ifdef EBUG
+  Utils::log_stream << "enter AssembleSource\n";
+#endif
+
+  binary = "";
+  object = "";
+  if (chdir(directory.c_str()) != 0) {
+    listing = "cannot change to '" + directory + "'";
+    Utils::log_stream << kTag << listing << endl;
+    return false;
+  }
+
+  Scanner in_scanner;
+  ostringstream out_stream;
+
+  in_scanner.OpenString(source);
+  Utils::log_stream.flush();
+  Utils::log_stream.setstate(ios::badbit);
+
+  assembler_.Reset();
+  assembler_.Assemble(in_scanner, "", out_stream);
+  binary = assembler_.GetBinaryImage();
+  if (want_object) {
+    assembler_.GetObjectImage(object);
+  }
+
+  Utils::log_stream.clear();
+  in_scanner.Close();
+  listing = out_stream.str();
+  Utils::log_stream << kTag << "assembled " << source.length()
+                    << " bytes in '" << directory << "'" << endl;
+
+#ifdef EBUG
+  Utils::log_stream << "leave AssembleSource\n";
+#endif
+  return true;
+}
+
+/******************************************************************************
+ * Function 'CurrentDirectory'.
+ *
+ * Returns:
+ *   the absolute path of the working directory, or "/" if it is unknown
+**/
+string AssemblerDaemon::CurrentDirectory() {
+  char buffer[4096];
+  if (getcwd(buffer, sizeof(buffer)) == NULL) {
+    return "/";
+  }
+  return string(buffer);
+}
+
+/******************************************************************************
+ * Function 'HandleConnection'.
+ * Serve requests on one connection until the client closes it.
+ *
+ * Parameters:
+ *   fd - the connected socket
+**/
+void AssemblerDaemon::HandleConnection(int fd) {
+  string magic = "";
+  string flags = "";
+  string source = "";
+  string directory = "";
+
+  while (this->ReadAll(fd, magic, kRequestMagic.length())) {
+    if (magic != kRequestMagic ||
+        !this->ReadAll(fd, flags, sizeof(uint64_t)) ||
+        !this->ReadString(fd, source) ||
+        !this->ReadString(fd, directory)) {
+      Utils::log_stream << kTag << "malformed request" << endl;
+      return;
+    }
+    uint64_t want_object = 0;
+    flags.copy(reinterpret_cast<char *>(&want_object), sizeof(want_object));
+
+    string listing = "";
+    string binary = "";
+    string object = "";
+    string reply = "";
+    if (this->AssembleSource(source, directory, want_object != 0, listing,
+                             binary, object)) {
+      reply = kReplyMagic;
+      PutString(reply, listing);
+      PutString(reply, binary);
+      PutString(reply, object);
+    } else {
+      reply = kErrorMagic;
+      PutString(reply, listing);
+    }
+    if (!this->WriteAll(fd, reply)) {
+      return;
+    }
+  }
+}
+
+/******************************************************************************
+ * Function 'ReadAll'.
+ * Read exactly 'how_many' bytes from a socket.
+ *
+ * Returns:
+ *   true if all the bytes were read
+**/
+bool AssemblerDaemon::ReadAll(int fd, string& s, size_t how_many) {
+  s.resize(how_many);
+  size_t done = 0;
+  while (done < how_many) {
+    ssize_t got = read(fd, &s[done], how_many - done);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      return false;
+    }
+    done += got;
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Function 'ReadString'.
+ * Read a string sent as a 64-bit length and the bytes.
+ *
+ * Returns:
+ *   true if the whole string was read
+**/
+bool AssemblerDaemon::ReadString(int fd, string& s) {
+  string length_bytes = "";
+  if (!ReadAll(fd, length_bytes, sizeof(uint64_t))) {
+    return false;
+  }
+  uint64_t length = 0;
+  length_bytes.copy(reinterpret_cast<char *>(&length), sizeof(length));
+  if (length > kMaxMessage) {
+    return false;
+  }
+  return ReadAll(fd, s, length);
+}
+
+/******************************************************************************
+ * Function 'Request'.
+ * The client side: send one source text to a running daemon and wait
+ * for the results.
+ *
+ * Parameters:
+ *   socket_name - the path of the daemon's socket
+ *   source - the bytes of the source file
+ *   want_object - whether to have an object file written as well
+ *   listing - the listing that 'Aprog' would write
+ *   binary - the '.bin' image
+ *   object - the object file, empty if none was written
+ *   error - the daemon's message if it could not assemble the source
+ *
+ * Returns:
+ *   true if the daemon answered with the results
+**/
+bool AssemblerDaemon::Request(string socket_name, const string& source,
+                              bool want_object, string& listing,
+                              string& binary, string& object,
+                              string& error) {
+  struct sockaddr_un address;
+  if (socket_name.length() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socket_name.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  if (connect(fd, reinterpret_cast<struct sockaddr *>(&address),
+              sizeof(address)) != 0) {
+    close(fd);
+    return false;
+  }
+
+  uint64_t flags = want_object ? 1 : 0;
+  string request = kRequestMagic;
+  request.append(reinterpret_cast<const char *>(&flags), sizeof(flags));
+  PutString(request, source);
+  PutString(request, CurrentDirectory());
+
+  string magic = "";
+  error = "";
+  bool answered = WriteAll(fd, request) &&
+                  ReadAll(fd, magic, kReplyMagic.length());
+  if (answered && magic == kErrorMagic) {
+    if (!ReadString(fd, error)) {
+      error = "";
+    }
+    answered = false;
+  } else {
+    answered = answered && magic == kReplyMagic &&
+               ReadString(fd, listing) &&
+               ReadString(fd, binary) &&
+               ReadString(fd, object);
+  }
+  close(fd);
+  return answered;
+}
+
+/******************************************************************************
+ * Function 'Serve'.
+ * This top level function binds the socket, starts the workers, and restarts any that die, until it is sent SIGINT
+ * or SIGTERM.
+ *
+ * Parameters:
+ *   log_filename - the base name for the logs; worker 'n' logs to
+ *                  'log_filename' with 'n' appended
+ *
+ * Returns:
+ *   0 on a clean shutdown, 1 if the socket could not be set up
+**/
+int AssemblerDaemon::Serve(string log_filename) {
+#ifdef EBUG
+  Utils::log_stream << "enter Serve\n";
+#endif
+
+  struct sockaddr_un address;
+  if (socket_name_.length() >= sizeof(address.sun_path)) {
+    Utils::log_stream << kTag << "socket name too long '"
+                      << socket_name_ << "'" << endl;
+    return 1;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socket_name_.c_str());
+
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(socket_name_.c_str());
+  if (listen_fd < 0 ||
+      bind(listen_fd, reinterpret_cast<struct sockaddr *>(&address),
+           sizeof(address)) != 0 ||
+      listen(listen_fd, SOMAXCONN) != 0) {
+    Utils::log_stream << kTag << "cannot listen on '"
+                      << socket_name_ << "'" << endl;
+    return 1;
+  }
+
+  // no SA_RESTART, so that 'waitpid' returns when we are told to stop
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = RequestStop;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  workers_.assign(how_many_workers_, -1);
+  for (int i = 0; i < how_many_workers_; ++i) {
+    workers_[i] = this->StartWorker(listen_fd, i, log_filename);
+  }
+  Utils::log_stream << kTag << "listening on '" << socket_name_ << "' with "
+                    << how_many_workers_ << " workers" << endl;
+
+  while (!stop_requested) {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid <= 0 || stop_requested) {
+      continue;
+    }
+    for (int i = 0; i < how_many_workers_; ++i) {
+      if (workers_[i] == pid) {
+        Utils::log_stream << kTag << "worker " << i << " died, restarting"
+                          << endl;
+        workers_[i] = this->StartWorker(listen_fd, i, log_filename);
+      }
+    }
+  }
+
+  for (int i = 0; i < how_many_workers_; ++i) {
+    if (workers_[i] > 0) {
+      kill(workers_[i], SIGTERM);
+    }
+  }
+  while (waitpid(-1, NULL, 0) > 0) {
+  }
+  close(listen_fd);
+  unlink(socket_name_.c_str());
+  Utils::log_stream << kTag << "stopped" << endl;
+
+#ifdef EBUG
+  Utils::log_stream << "leave Serve\n";
+#endif
+  return 0;
+}
+
+/******************************************************************************
+ * Function 'StartWorker'.
+ * Fork one worker. The worker gets its own log, and its standard output,
+ * where the assembler echoes its progress, is discarded without even
+ * being formatted.
+ *
+ * Returns:
+ *   the process id of the worker, or -1 if the fork failed
+**/
+int AssemblerDaemon::StartWorker(int listen_fd, int worker_number,
+                                 string log_filename) {
+  Utils::log_stream.flush();
+  cout.flush();
+
+  pid_t pid = fork();
+  if (pid != 0) {
+    return pid;
+  }
+
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+  if (freopen("/dev/null", "w", stdout) == NULL) {
+    Utils::log_stream << kTag << "cannot discard standard output" << endl;
+  }
+  cout.setstate(ios::badbit);
+
+  Utils::log_stream.close();
+  Utils::log_stream.clear();
+  Utils::LogFileOpen(log_filename + to_string(worker_number) + ".txt");
+  this->Work(listen_fd);
+  exit(0);
+}
+
+/******************************************************************************
+ * Function 'Work'.
+ * The body of a worker: accept connections and serve them, forever.
+ *
+ * Parameters:
+ *   listen_fd - the listening socket shared by all the workers
+**/
+void AssemblerDaemon::Work(int listen_fd) {
+  while (true) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) {
+      continue;
+    }
+    this->HandleConnection(fd);
+    close(fd);
+  }
+}
+
+/******************************************************************************
+ * Function 'WriteAll'.
+ * Write all of a string to a socket.
+ *
+ * Returns:
+ *   true if all the bytes were written
+**/
+bool AssemblerDaemon::WriteAll(int fd, const string& s) {
+  size_t done = 0;
+  while (done < s.length()) {
+    ssize_t put = write(fd, s.data() + done, s.length() - done);
+    if (put < 0 && errno == EINTR) {
+      continue;
+    }
+    if (put <= 0) {
+      return false;
+    }
+    done += put;
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+/****************************************************************
+ * Header file for the 'AssemblerDaemon' class, a resident assembler
+ * that serves requests over a Unix domain socket.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../../Utilities/scanner.h"
+#include "../../Utilities/utils.h"
+
+#include "globals.h"
+#include "pullet16assembler.h"
+
+class AssemblerDaemon {
+  public:
+    AssemblerDaemon(string socket_name, int how_many_workers);
+    virtual ~AssemblerDaemon();
+
+    static const string kDefaultSocket;
+
+    static bool Request(string socket_name, const string& source,
+                        bool want_object, string& listing, string& binary,
+                        string& object, string& error);
+    int Serve(string log_filename);
+
+  private:
+    string socket_name_;
+    int how_many_workers_;
+    vector<int> workers_;
+
+    Assembler assembler_;
+
+    bool AssembleSource(const string& source, const string& directory,
+                        bool want_object, string& listing, string& binary,
+                        string& object);
+    static string CurrentDirectory();
+    void HandleConnection(int fd);
+    static bool ReadAll(int fd, string& s, size_t how_many);
+    static bool ReadString(int fd, string& s);
+    static bool WriteAll(int fd, const string& s);
+    int StartWorker(int listen_fd, int worker_number, string log_filename);
+    void Work(int listen_fd);
+};
+
+#endif
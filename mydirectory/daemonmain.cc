@@ -0,0 +1,65 @@
+#include "daemon.h"
+
+/****************************************************************
+ * Main program for the Pullet assembler daemon.
+ *
+ * Author/copyright:  Duncan Buell. All rights reserved.
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+ * Note that all file names are entered without extensions.
+ *
+ * Options may follow the log file name:
+ *   -socket name  listen on 'name' (default /tmp/pullet16.sock)
+ *   -workers n  run 'n' worker processes (default 4)
+ *
+ * The daemon runs until it is sent SIGINT or SIGTERM.
+**/
+
+static const string kTag = "DaemonMain: ";
+static const string kUsage = "logfilename [-socket name] [-workers n]";
+
+/****************************************************************
+ * Print the usage message and stop.
+**/
+static void Usage(char *argv[]) {
+  cout << kTag << "usage: " << argv[0] << " " << kUsage << endl;
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  string log_filename = "";
+  string socket_name = AssemblerDaemon::kDefaultSocket;
+  int how_many_workers = 4;
+
+  if (argc < 2) {
+    Usage(argv);
+  }
+  log_filename = static_cast<string>(argv[1]);
+
+  for (int i = 2; i < argc; ++i) {
+    string option = static_cast<string>(argv[i]);
+    if (option == "-socket" && i + 1 < argc) {
+      socket_name = static_cast<string>(argv[++i]);
+    } else if (option == "-workers" && i + 1 < argc) {
+      how_many_workers = Utils::StringToInteger(static_cast<string>(argv[++i]));
+    } else {
+      Usage(argv);
+    }
+  }
+
+  Utils::LogFileOpen(log_filename + ".txt");
+
+  Utils::log_stream << kTag << "Beginning execution\n";
+  Utils::log_stream.flush();
+
+  AssemblerDaemon daemon(socket_name, how_many_workers);
+  int status = daemon.Serve(log_filename);
+
+  Utils::log_stream << kTag << "Ending execution\n";
+  Utils::log_stream.flush();
+
+  Utils::FileClose(Utils::log_stream);
+
+  return status;
+}
@@ -0,0 +1,316 @@
+#include "disassembler.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'Disassembler' for turning a '.bin' image back into a listing.
+ *
+ * The decode is a single lookup on the top four bits of each word: the
+ * three opcode bits and the indirect bit. The table is built from the
+ * same 'Globals' opcode tables that 'PassTwo' uses to encode.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "Disassembler: ";
+
+/******************************************************************************
+ * Constructor
+**/
+Disassembler::Disassembler() {
+  globals_ = Globals();
+
+  for (int i = 0; i < 16; ++i) {
+    int opcode = i >> 1;
+    decode_table_[i].mnemonic = &Globals::kOpcodeMnemonics[opcode];
+    decode_table_[i].is_format_two = (opcode == Globals::kFormatTwoOpcode);
+    decode_table_[i].is_indirect = ((i & 1) == 1);
+  }
+}
+
+/******************************************************************************
+ * Destructor
+**/
+Disassembler::~Disassembler() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'AppendBits'.
+ * Append the low 'how_many_bits' of a value as a string of 0s and 1s.
+ *
+ * Parameters:
+ *   s - the string to append to
+ *   value - the value to convert
+ *   how_many_bits - the number of bits to write
+**/
+void Disassembler::AppendBits(string& s, int value,
+                              int how_many_bits) const {
+  for (int i = how_many_bits - 1; i >= 0; --i) {
+    s += ((value >> i) & 1) ? '1' : '0';
+  }
+}
+
+/******************************************************************************
+ * Function 'AppendDecimal'.
+ * Append a nonnegative value right justified in a field of 'width'.
+ *
+ * Parameters:
+ *   s - the string to append to
+ *   value - the value to convert
+ *   width - the width of the output field
+**/
+void Disassembler::AppendDecimal(string& s, int value, int width) const {
+  char digits[12];
+  int how_many = 0;
+
+  do {
+    digits[how_many++] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+
+  for (int i = how_many; i < width; ++i) {
+    s += ' ';
+  }
+  while (how_many > 0) {
+    s += digits[--how_many];
+  }
+}
+
+/******************************************************************************
+ * Function 'AppendHexOperand'.
+ * Append a 16-bit value in the signed five character form that 'Hex'
+ * parses, so that the listing can be fed back to the assembler.
+ *
+ * Parameters:
+ *   s - the string to append to
+ *   value - the 16-bit value
+**/
+void Disassembler::AppendHexOperand(string& s, int value) const {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+
+  if (value >= 0x8000) {
+    s += '-';
+    value = 65536 - value;
+  } else {
+    s += '+';
+  }
+  for (int shift = 12; shift >= 0; shift -= 4) {
+    s += kHexDigits[(value >> shift) & 0xF];
+  }
+}
+
+/******************************************************************************
+ * Function 'AppendLabel'.
+ * Append the three character label for a reconstructed symbol. Labels are
+ * numbered in address order as a letter and two base-36 digits.
+ *
+ * Parameters:
+ *   s - the string to append to
+ *   label_number - the sequence number of the label
+**/
+void Disassembler::AppendLabel(string& s, int label_number) const {
+  static const char kDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+  s += static_cast<char>('A' + label_number / (36 * 36));
+  s += kDigits[(label_number / 36) % 36];
+  s += kDigits[label_number % 36];
+}
+
+/******************************************************************************
+ * Function 'AppendLine'.
+ * Append the listing line for one word, in the column layout of
+ * 'CodeLine::ToString'. Words that do not decode to an instruction are
+ * shown as 'HEX' data.
+ *
+ * Parameters:
+ *   s - the string to append to
+ *   pc - the address of the word
+ *   word - the 16-bit word
+**/
+void Disassembler::AppendLine(string& s, int pc, int word) const {
+  const DecodeEntry& entry = decode_table_[word >> 12];
+  int address = word & 0xFFF;
+  const string *mnemonic = entry.mnemonic;
+  bool is_data = false;
+
+  if (entry.is_format_two) {
+    if (entry.is_indirect || address < 1 || address > 3) {
+      is_data = true;
+    } else {
+      mnemonic = &Globals::kFormatTwoMnemonics[address];
+    }
+  }
+
+  this->AppendDecimal(s, pc, 5);
+  s += ' ';
+  this->AppendDecimal(s, pc, 4);
+  s += "  ";
+  this->AppendBits(s, pc, 12);
+  s += ' ';
+  this->AppendBits(s, word >> 12, 4);
+  s += ' ';
+  this->AppendBits(s, word >> 8, 4);
+  s += ' ';
+  this->AppendBits(s, word >> 4, 4);
+  s += ' ';
+  this->AppendBits(s, word, 4);
+
+  s += ' ';
+  if (labels_[pc] >= 0) {
+    this->AppendLabel(s, labels_[pc]);
+  } else {
+    s += "...";
+  }
+
+  s += "    ";
+  s += is_data ? "HEX" : *mnemonic;
+
+  s += ' ';
+  s += (!entry.is_format_two && entry.is_indirect) ? '*' : ' ';
+
+  s += ' ';
+  if (!entry.is_format_two && labels_[address] >= 0) {
+    this->AppendLabel(s, labels_[address]);
+    s += " .....";
+  } else if (!entry.is_format_two) {
+    s += "... ";
+    this->AppendHexOperand(s, address);
+  } else if (is_data) {
+    s += "... ";
+    this->AppendHexOperand(s, word);
+  } else {
+    s += "... .....";
+  }
+
+  s += '\n';
+}
+
+/******************************************************************************
+ * Function 'Disassemble'.
+ * This top level function maps a binary file and writes its listing.
+ *
+ * Parameters:
+ *   binary_filename - the '.bin' file written by 'WriteBinaryFile'
+ *   out_stream - the output stream to write to
+ *
+ * Returns:
+ *   the number of words disassembled, or -1 if the file can't be read
+**/
+int Disassembler::Disassemble(string binary_filename, ofstream& out_stream) {
+#ifdef EBUG
+  Utils::log_stream << "enter Disassemble\n";
+#endif
+
+  int fd = open(binary_filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    Utils::log_stream << kTag << "open failed for '"
+                      << binary_filename << "'" << endl;
+    return -1;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return -1;
+  }
+
+  int how_many = static_cast<int>(file_stat.st_size / sizeof(uint16_t));
+  if (how_many > Globals::kMaxMemory) {
+    how_many = Globals::kMaxMemory;
+  }
+
+  string listing = "";
+  if (how_many > 0) {
+    void *mapped = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      close(fd);
+      Utils::log_stream << kTag << "mmap failed for '"
+                        << binary_filename << "'" << endl;
+      return -1;
+    }
+    listing = this->Listing(static_cast<const uint16_t *>(mapped), how_many);
+    munmap(mapped, file_stat.st_size);
+  }
+  close(fd);
+
+  out_stream.write(listing.data(), listing.size());
+  Utils::log_stream << kTag << "disassembled " << how_many << " words from '"
+                    << binary_filename << "'" << endl;
+
+#ifdef EBUG
+  Utils::log_stream << "leave Disassemble\n";
+#endif
+  return how_many;
+}
+
+/******************************************************************************
+ * Function 'FindLabels'.
+ * Mark every address that is the target of a Format I instruction and
+ * number the targets in address order.
+ *
+ * Parameters:
+ *   words - the memory image
+ *   how_many - the number of words in the image
+**/
+void Disassembler::FindLabels(const uint16_t *words, int how_many) {
+  for (int i = 0; i < Globals::kMaxMemory; ++i) {
+    labels_[i] = -1;
+  }
+
+  for (int pc = 0; pc < how_many; ++pc) {
+    int word = words[pc];
+    if (!decode_table_[word >> 12].is_format_two) {
+      int address = word & 0xFFF;
+      if (address < how_many) {
+        labels_[address] = 0;
+      }
+    }
+  }
+
+  int label_number = 0;
+  for (int pc = 0; pc < how_many; ++pc) {
+    if (labels_[pc] == 0) {
+      labels_[pc] = label_number;
+      ++label_number;
+    }
+  }
+}
+
+/******************************************************************************
+ * Function 'Listing'.
+ * Produce the listing for a memory image.
+ *
+ * Parameters:
+ *   words - the memory image
+ *   how_many - the number of words in the image
+ *
+ * Returns:
+ *   the listing, one line per word
+**/
+string Disassembler::Listing(const uint16_t *words, int how_many) {
+  string s = "";
+
+  this->FindLabels(words, how_many);
+
+  // every line is the same 67 characters plus the newline
+  s.reserve(68 * how_many);
+  for (int pc = 0; pc < how_many; ++pc) {
+    this->AppendLine(s, pc, words[pc]);
+  }
+
+  return s;
+}
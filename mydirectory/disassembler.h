@@ -0,0 +1,51 @@
+/****************************************************************
+ * Header file for the Pullet16 disassembler.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdint>
+using namespace std;
+
+#include "../../Utilities/utils.h"
+
+#include "globals.h"
+
+class Disassembler {
+  public:
+    Disassembler();
+    virtual ~Disassembler();
+
+    int Disassemble(string binary_filename, ofstream& out_stream);
+    string Listing(const uint16_t *words, int how_many);
+
+  private:
+    struct DecodeEntry {
+      const string *mnemonic;
+      bool is_format_two;
+      bool is_indirect;
+    };
+
+    DecodeEntry decode_table_[16];
+    int labels_[Globals::kMaxMemory];
+
+    Globals globals_;
+
+    void AppendBits(string& s, int value, int how_many_bits) const;
+    void AppendDecimal(string& s, int value, int width) const;
+    void AppendHexOperand(string& s, int value) const;
+    void AppendLabel(string& s, int label_number) const;
+    void AppendLine(string& s, int pc, int word) const;
+    void FindLabels(const uint16_t *words, int how_many);
+};
+
+#endif
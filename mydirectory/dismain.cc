@@ -0,0 +1,44 @@
+#include "disassembler.h"
+
+/****************************************************************
+ * Main program for Pullet Disassembler program.
+ *
+ * Author/copyright:  Duncan Buell. All rights reserved.
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+ * Note that all file names are entered without extensions.
+**/
+
+static const string kTag = "DisMain: ";
+
+int main(int argc, char *argv[]) {
+  string binary_filename = "";
+  string out_filename = "";
+  string log_filename = "";
+
+  ofstream out_stream;
+
+  Disassembler disassembler;
+
+  Utils::CheckArgs(3, argc, argv, "binaryfilename outfilename logfilename");
+  binary_filename = static_cast<string>(argv[1]) + ".bin";
+  out_filename = static_cast<string>(argv[2]) + ".txt";
+  log_filename = static_cast<string>(argv[3]) + ".txt";
+
+  Utils::LogFileOpen(log_filename);
+  Utils::FileOpen(out_stream, out_filename);
+
+  Utils::log_stream << kTag << "Beginning execution\n";
+  Utils::log_stream.flush();
+
+  int how_many = disassembler.Disassemble(binary_filename, out_stream);
+
+  Utils::log_stream << kTag << "Ending execution\n";
+  Utils::log_stream.flush();
+
+  Utils::FileClose(out_stream);
+  Utils::FileClose(Utils::log_stream);
+
+  return (how_many < 0) ? 1 : 0;
+}
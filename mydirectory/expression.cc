@@ -0,0 +1,287 @@
+#include "expression.h"
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'Expression' as a container for one constant expression operand.
+ *
+ * An expression is a sum and difference of terms, and a term is a
+ * product of factors. A factor is a symbol of one to three letters and
+ * digits, starting with a letter, or a decimal number. There are no
+ * blanks and no parentheses, and a leading sign is allowed:
+ *
+ *   TOP+3   LEN*2   END-TOP+1   -2*LEN
+ *
+ * The text is parsed once, when the line is read, and evaluated once the
+ * symbol table is final.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const long kMaxMagnitude = 1L << 24;
+
+/******************************************************************************
+ * Constructor
+**/
+Expression::Expression() {
+  is_invalid_ = true;
+  is_scaled_ = false;
+  relocation_ = 0;
+  value_ = 0;
+}
+
+/******************************************************************************
+ * Constructor
+**/
+Expression::Expression(string text) {
+  text_ = text;
+  is_scaled_ = false;
+  relocation_ = 0;
+  value_ = 0;
+  this->ParseExpression();
+}
+
+/******************************************************************************
+ * Destructor
+**/
+Expression::~Expression() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * Accessor for 'error_messages_'.
+**/
+string Expression::GetErrorMessages() const {
+  return error_messages_;
+}
+
+/******************************************************************************
+ * Accessor for the symbols named in the expression, each padded with
+ * blanks to the three characters of a label.
+**/
+vector<string> Expression::GetSymbols() const {
+  vector<string> symbols;
+  for (auto term = terms_.begin(); term != terms_.end(); ++term) {
+    for (auto it = term->factors.begin(); it != term->factors.end(); ++it) {
+      if (!isdigit(it->at(0))) {
+        symbols.push_back(*it);
+      }
+    }
+  }
+  return symbols;
+}
+
+/******************************************************************************
+ * Accessor for 'text_'.
+**/
+string Expression::GetText() const {
+  return text_;
+}
+
+/******************************************************************************
+ * Accessor for 'value_'.
+**/
+int Expression::GetValue() const {
+  return value_;
+}
+
+/******************************************************************************
+ * Accessor for error flags.
+**/
+bool Expression::HasAnError() const {
+  return is_invalid_;
+}
+
+/******************************************************************************
+ * Accessor for whether the value is a plain number, which does not move
+ * when the module is relocated.
+**/
+bool Expression::IsAbsolute() const {
+  return !is_scaled_ && relocation_ == 0;
+}
+
+/******************************************************************************
+ * Accessor for whether the value is one address plus or minus a number,
+ * which moves with the module.
+**/
+bool Expression::IsRelocatable() const {
+  return !is_scaled_ && relocation_ == 1;
+}
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'Evaluate'.
+ * Compute the value from the symbol table.
+ *
+ * Parameters:
+ *   symbols - the symbol table, with the values of any equates needed
+ *   absolutes - the symbols that are numbers rather than addresses
+ *
+ * Returns:
+ *   true if every symbol was defined and the value is in range
+**/
+bool Expression::Evaluate(const map<string, int>& symbols,
+                          const set<string>& absolutes) {
+#ifdef EBUG
+  Utils::log_stream << "enter Evaluate\n";
+#endif
+
+  if (is_invalid_) {
+    return false;
+  }
+
+  long sum = 0;
+  relocation_ = 0;
+  is_scaled_ = false;
+  for (auto term = terms_.begin(); term != terms_.end(); ++term) {
+    long product = term->sign;
+    int addresses = 0;
+    for (auto it = term->factors.begin(); it != term->factors.end(); ++it) {
+      if (isdigit(it->at(0))) {
+        product *= atol(it->c_str());
+      } else {
+        auto found = symbols.find(*it);
+        if (found == symbols.end()) {
+          error_messages_ += "\n***** ERROR -- SYMBOL " + *it
+                           + " IN EXPRESSION " + text_ + " IS UNDEFINED";
+          is_invalid_ = true;
+          return false;
+        }
+        product *= found->second;
+        if (absolutes.count(*it) == 0) {
+          ++addresses;
+        }
+      }
+      if (product > kMaxMagnitude || product < -kMaxMagnitude) {
+        error_messages_ += "\n***** ERROR -- EXPRESSION " + text_
+                         + " IS OUT OF RANGE";
+        is_invalid_ = true;
+        return false;
+      }
+    }
+
+    if (addresses == 1 && term->factors.size() == 1) {
+      relocation_ += term->sign;
+    } else if (addresses > 0) {
+      is_scaled_ = true;
+    }
+    sum += product;
+  }
+
+  value_ = static_cast<int>(sum);
+
+#ifdef EBUG
+  Utils::log_stream << "leave Evaluate " << value_ << endl;
+#endif
+  return true;
+}
+
+/******************************************************************************
+ * Function 'IsExpression'.
+ * Whether the operand columns of a line hold an expression rather than
+ * the usual symbol in columns 10-12 and hex operand in columns 14-18.
+ * An expression may start in either field and run to column 18.
+ *
+ * Parameters:
+ *   operand - columns 10 through 18 of the line
+**/
+bool Expression::IsExpression(string operand) {
+  operand.resize(9, ' ');
+  if (operand.find_first_of("+-*") == string::npos) {
+    return false;
+  }
+
+  //A sign at the front of the hex operand is part of the hex operand,
+  //valid or not, so an expression there may not start with a sign.
+  return operand.substr(0, 3).find_first_of("+-*") != string::npos ||
+         operand.at(3) != ' ' ||
+         operand.find_first_of("+-*", 5) != string::npos;
+}
+
+/******************************************************************************
+ * Function 'ParseExpression'.
+ * Split the text into signed terms of factors and set the error flag.
+**/
+void Expression::ParseExpression() {
+#ifdef EBUG
+  Utils::log_stream << "enter ParseExpression\n";
+#endif
+
+  is_invalid_ = false;
+  terms_.clear();
+
+  Term term;
+  term.sign = 1;
+  size_t i = 0;
+  if (i < text_.length() && (text_.at(i) == '+' || text_.at(i) == '-')) {
+    term.sign = (text_.at(i) == '-') ? -1 : 1;
+    ++i;
+  }
+
+  while (!is_invalid_) {
+    size_t start = i;
+    if (i < text_.length() && isdigit(text_.at(i))) {
+      while (i < text_.length() && isdigit(text_.at(i))) {
+        ++i;
+      }
+      is_invalid_ = (i - start > 5);
+    } else if (i < text_.length() && isalpha(text_.at(i))) {
+      while (i < text_.length() && isalnum(text_.at(i))) {
+        ++i;
+      }
+      is_invalid_ = (i - start > 3);
+    } else {
+      is_invalid_ = true;
+    }
+
+    string factor = text_.substr(start, i - start);
+    if (!isdigit(factor.empty() ? ' ' : factor.at(0))) {
+      factor.resize(3, ' ');
+    }
+    term.factors.push_back(factor);
+
+    if (i == text_.length()) {
+      terms_.push_back(term);
+      break;
+    }
+
+    char op = text_.at(i++);
+    if (op == '+' || op == '-') {
+      terms_.push_back(term);
+      term.sign = (op == '-') ? -1 : 1;
+      term.factors.clear();
+    } else if (op != '*') {
+      is_invalid_ = true;
+    }
+  }
+
+  if (is_invalid_) {
+    terms_.clear();
+    error_messages_ = "\n***** ERROR -- EXPRESSION " + text_ + " IS INVALID";
+  }
+
+#ifdef EBUG
+  Utils::log_stream << "leave ParseExpression\n";
+#endif
+}
+
+/******************************************************************************
+ * Function 'ToString'.
+ * This function formats an 'Expression' for prettyprinting in the nine
+ * columns of the symbolic and hex operands.
+ *
+ * Returns:
+ *   the prettyprint string for printing
+**/
+string Expression::ToString() const {
+  string s = text_;
+  s.resize(9, ' ');
+  return s;
+}
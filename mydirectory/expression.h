@@ -0,0 +1,61 @@
+/****************************************************************
+ * Header file for the 'Expression' class to contain one constant
+ * expression operand such as 'TOP+3' or 'LEN*2'.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <iostream>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../../Utilities/utils.h"
+
+class Expression {
+  public:
+    Expression();
+    Expression(string text);
+    virtual ~Expression();
+
+    string GetErrorMessages() const;
+    vector<string> GetSymbols() const;
+    string GetText() const;
+    int GetValue() const;
+    bool HasAnError() const;
+    bool IsAbsolute() const;
+    bool IsRelocatable() const;
+
+    bool Evaluate(const map<string, int>& symbols,
+                  const set<string>& absolutes);
+    static bool IsExpression(string operand);
+    string ToString() const;
+
+  private:
+    struct Term {
+      int sign;
+      vector<string> factors;
+    };
+
+    bool is_invalid_;
+    bool is_scaled_;
+    int relocation_;
+    int value_;
+    string error_messages_;
+    string text_;
+    vector<Term> terms_;
+
+    void ParseExpression();
+};
+
+#endif
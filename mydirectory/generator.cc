@@ -0,0 +1,329 @@
+#include "generator.h"
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'CorpusGenerator' for writing synthetic source programs.
+ *
+ * Every line is laid out in the fixed columns that 'PassOne' slices: the
+ * label in 0-2, the mnemonic in 4-6, the indirect flag in 8, the symbolic
+ * operand in 10-12, the hex operand in 14-18, and comments from 20 on.
+ *
+ * The kind of each instruction line is drawn from the weights given to
+ * 'SetMix'. A percentage of the lines carry labels, and Format I operands
+ * name one of those labels, with 'SetReusePercent' of them going to a
+ * small set of heavily used symbols. With 'SetErrorPercent' some lines
+ * are made invalid on purpose: a bad mnemonic, a bad hex operand, a label
+ * used twice, or an undefined symbolic operand.
+ *
+ * The generator has its own xorshift random numbers, so a seed gives the
+ * same program on every machine.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "CorpusGenerator: ";
+static const int kFormatOne = 0;
+static const int kFormatTwo = 1;
+static const int kHex = 2;
+static const int kDs = 3;
+static const int kOrg = 4;
+static const int kHowManyHot = 8;
+
+/******************************************************************************
+ * Constructor
+ *
+ * Parameters:
+ *   seed - the seed for the random numbers
+**/
+CorpusGenerator::CorpusGenerator(uint64_t seed) {
+  globals_ = Globals();
+  seed_ = (seed != 0) ? seed : 1;
+
+  has_end_ = true;
+  comment_length_ = 11;
+  comment_percent_ = 5;
+  error_percent_ = 0;
+  label_percent_ = 25;
+  reuse_percent_ = 0;
+  this->SetMix(65, 10, 19, 5, 1);
+}
+
+/******************************************************************************
+ * Destructor
+**/
+CorpusGenerator::~CorpusGenerator() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * Mutator 'SetCommentLength'.
+ * Set the length of the comment at the end of each line.
+**/
+void CorpusGenerator::SetCommentLength(int length) {
+  comment_length_ = (length > 0) ? length : 0;
+}
+
+/******************************************************************************
+ * Mutator 'SetCommentPercent'.
+ * Set the percentage of instruction lines preceded by a comment line.
+**/
+void CorpusGenerator::SetCommentPercent(int percent) {
+  comment_percent_ = percent;
+}
+
+/******************************************************************************
+ * Mutator 'SetEnd'.
+ * Set whether the program ends with an 'END' statement.
+**/
+void CorpusGenerator::SetEnd(bool has_end) {
+  has_end_ = has_end;
+}
+
+/******************************************************************************
+ * Mutator 'SetErrorPercent'.
+ * Set the percentage of instruction lines that are made invalid.
+**/
+void CorpusGenerator::SetErrorPercent(int percent) {
+  error_percent_ = percent;
+}
+
+/******************************************************************************
+ * Mutator 'SetLabelPercent'.
+ * Set the percentage of instruction lines that carry a label.
+**/
+void CorpusGenerator::SetLabelPercent(int percent) {
+  label_percent_ = percent;
+}
+
+/******************************************************************************
+ * Mutator 'SetMix'.
+ * Set the relative weights of the kinds of instruction line.
+ *
+ * Parameters:
+ *   format_one - the weight of Format I instructions
+ *   format_two - the weight of Format II instructions
+ *   hex - the weight of 'HEX' data
+ *   ds - the weight of 'DS' storage
+ *   org - the weight of 'ORG' statements
+**/
+void CorpusGenerator::SetMix(int format_one, int format_two, int hex,
+                             int ds, int org) {
+  weights_[kFormatOne] = (format_one > 0) ? format_one : 0;
+  weights_[kFormatTwo] = (format_two > 0) ? format_two : 0;
+  weights_[kHex] = (hex > 0) ? hex : 0;
+  weights_[kDs] = (ds > 0) ? ds : 0;
+  weights_[kOrg] = (org > 0) ? org : 0;
+  if (weights_[kFormatOne] + weights_[kFormatTwo] + weights_[kHex]
+      + weights_[kDs] + weights_[kOrg] == 0) {
+    weights_[kFormatOne] = 1;
+  }
+}
+
+/******************************************************************************
+ * Mutator 'SetReusePercent'.
+ * Set the percentage of Format I operands that name one of a few heavily
+ * used symbols instead of any label in the program.
+**/
+void CorpusGenerator::SetReusePercent(int percent) {
+  reuse_percent_ = percent;
+}
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'Comment'.
+ * A comment of the configured length, starting with '*'. It is never
+ * shorter than the '*', since an empty line would end the source.
+**/
+string CorpusGenerator::Comment() {
+  static const string kFiller = "* generated line of the synthetic corpus ";
+
+  int length = (comment_length_ > 1) ? comment_length_ : 1;
+  string s = "";
+  while (static_cast<int>(s.length()) < length) {
+    s += kFiller;
+  }
+  return s.substr(0, length);
+}
+
+/******************************************************************************
+ * Function 'Generate'.
+ * Generate a program.
+ *
+ * Parameters:
+ *   how_many_lines - the number of instruction lines, not counting
+ *                    comment lines and the 'END'
+ *
+ * Returns:
+ *   the text of the source file
+**/
+string CorpusGenerator::Generate(int how_many_lines) {
+#ifdef EBUG
+  Utils::log_stream << "enter Generate\n";
+#endif
+
+  // decide the labels first so that operands can refer forward
+  vector<int> label_numbers(how_many_lines, -1);
+  int how_many_labels = 0;
+  for (int i = 0; i < how_many_lines; ++i) {
+    if (this->Percent() < label_percent_) {
+      label_numbers[i] = how_many_labels++;
+    }
+  }
+  if (how_many_labels == 0 && how_many_lines > 0) {
+    label_numbers[0] = how_many_labels++;
+  }
+
+  int total_weight = 0;
+  for (int i = 0; i < 5; ++i) {
+    total_weight += weights_[i];
+  }
+
+  string source = "";
+  int pc = 0;
+  for (int i = 0; i < how_many_lines; ++i) {
+    if (this->Percent() < comment_percent_) {
+      source += this->Comment() + "\n";
+    }
+
+    int pick = this->NextRandom() % total_weight;
+    int kind = 0;
+    while (pick >= weights_[kind]) {
+      pick -= weights_[kind];
+      ++kind;
+    }
+
+    string label = "   ";
+    if (label_numbers[i] >= 0) {
+      label = this->Label(label_numbers[i]);
+    }
+    string mnemonic = "";
+    string addr = " ";
+    string symoperand = "   ";
+    string hexoperand = "     ";
+
+    if (kind == kFormatOne) {
+      mnemonic = Globals::kOpcodeMnemonics[this->NextRandom() %
+                                           Globals::kFormatTwoOpcode];
+      if (this->Percent() < 10) {
+        addr = "*";
+      }
+      int hot = (how_many_labels < kHowManyHot) ? how_many_labels
+                                                 : kHowManyHot;
+      if (this->Percent() < reuse_percent_) {
+        symoperand = this->Label(this->NextRandom() % hot);
+      } else {
+        symoperand = this->Label(this->NextRandom() % how_many_labels);
+      }
+    } else if (kind == kFormatTwo) {
+      mnemonic = Globals::kFormatTwoMnemonics[1 + this->NextRandom() % 3];
+    } else if (kind == kHex) {
+      mnemonic = "HEX";
+      int value = this->NextRandom() % 0xFFFF - 0x7FFF;
+      hexoperand = this->HexOperand(value);
+    } else if (kind == kDs) {
+      mnemonic = "DS ";
+      hexoperand = this->HexOperand(1 + this->NextRandom() % 4);
+    } else {
+      // an 'ORG' to where the PC already is keeps the program valid
+      mnemonic = "ORG";
+      hexoperand = this->HexOperand(pc);
+    }
+
+    if (this->Percent() < error_percent_) {
+      int error = this->NextRandom() % 4;
+      if (error == 0) {
+        mnemonic = "XYZ";
+      } else if (error == 1) {
+        hexoperand = "+0G0Z";
+      } else if (error == 2 && how_many_labels > 0) {
+        label = this->Label(this->NextRandom() % how_many_labels);
+      } else {
+        symoperand = "ZZZ";
+      }
+    }
+
+    source += this->Line(label, mnemonic, addr, symoperand, hexoperand);
+    pc += 1;
+  }
+
+  if (has_end_) {
+    source += this->Line("   ", "END", " ", "   ", "     ");
+  }
+
+#ifdef EBUG
+  Utils::log_stream << "leave Generate\n";
+#endif
+  return source;
+}
+
+/******************************************************************************
+ * Function 'HexOperand'.
+ * A value in the signed five character form that 'Hex' parses.
+**/
+string CorpusGenerator::HexOperand(int value) const {
+  static const char kHexDigits[] = "0123456789ABCDEF";
+
+  string s = (value < 0) ? "-" : "+";
+  if (value < 0) {
+    value = -value;
+  }
+  for (int shift = 12; shift >= 0; shift -= 4) {
+    s += kHexDigits[(value >> shift) & 0xF];
+  }
+  return s;
+}
+
+/******************************************************************************
+ * Function 'Label'.
+ * The three character name of a label, a letter and two base-36 digits.
+**/
+string CorpusGenerator::Label(int label_number) const {
+  static const char kDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+  string s = "";
+  s += static_cast<char>('A' + label_number / (36 * 36) % 26);
+  s += kDigits[(label_number / 36) % 36];
+  s += kDigits[label_number % 36];
+  return s;
+}
+
+/******************************************************************************
+ * Function 'Line'.
+ * Lay out one source line in the fixed columns.
+**/
+string CorpusGenerator::Line(string label, string mnemonic, string addr,
+                             string symoperand, string hexoperand) {
+  string s = label + " " + mnemonic + " " + addr + " " + symoperand + " "
+           + hexoperand;
+  if (comment_length_ > 0) {
+    s += " " + this->Comment();
+  }
+  return s + "\n";
+}
+
+/******************************************************************************
+ * Function 'NextRandom'.
+ * The next value from a xorshift generator.
+**/
+uint64_t CorpusGenerator::NextRandom() {
+  seed_ ^= seed_ << 13;
+  seed_ ^= seed_ >> 7;
+  seed_ ^= seed_ << 17;
+  return seed_;
+}
+
+/******************************************************************************
+ * Function 'Percent'.
+ * A random value from 0 to 99.
+**/
+int CorpusGenerator::Percent() {
+  return this->NextRandom() % 100;
+}
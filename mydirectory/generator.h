@@ -0,0 +1,60 @@
+/****************************************************************
+ * Header file for the 'CorpusGenerator' class, which writes synthetic
+ * Pullet16 source programs for scale testing.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+#include "../../Utilities/utils.h"
+
+#include "globals.h"
+
+class CorpusGenerator {
+  public:
+    CorpusGenerator(uint64_t seed);
+    virtual ~CorpusGenerator();
+
+    void SetCommentLength(int length);
+    void SetCommentPercent(int percent);
+    void SetEnd(bool has_end);
+    void SetErrorPercent(int percent);
+    void SetLabelPercent(int percent);
+    void SetMix(int format_one, int format_two, int hex, int ds, int org);
+    void SetReusePercent(int percent);
+
+    string Generate(int how_many_lines);
+
+  private:
+    bool has_end_;
+    int comment_length_;
+    int comment_percent_;
+    int error_percent_;
+    int label_percent_;
+    int reuse_percent_;
+    int weights_[5];
+    uint64_t seed_;
+
+    Globals globals_;
+
+    string Comment();
+    string HexOperand(int value) const;
+    string Label(int label_number) const;
+    string Line(string label, string mnemonic, string addr,
+                string symoperand, string hexoperand);
+    uint64_t NextRandom();
+    int Percent();
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include "generator.h"
+
+/****************************************************************
+ * Main program for the Pullet corpus generator.
+ *
+ * Author/copyright:  Duncan Buell. All rights reserved.
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+ * Note that all file names are entered without extensions.
+ *
+ * Options may follow the two file names:
+ *   -lines n  write 'n' instruction lines (default 1000)
+ *   -seed n  seed for the random numbers (default 1)
+ *   -mix f1 f2 hex ds org  relative weights of Format I, Format II,
+ *                          HEX, DS, and ORG lines (default 65 10 19 5 1)
+ *   -labels pct  percentage of lines with a label (default 25)
+ *   -reuse pct  percentage of operands naming a few hot symbols
+ *               (default 0)
+ *   -comments pct  percentage of lines preceded by a comment line
+ *                  (default 5)
+ *   -commentlength n  length of the comment on each line (default 11)
+ *   -errors pct  percentage of lines made invalid (default 0)
+ *   -noend  leave off the 'END' statement
+**/
+
+static const string kTag = "GenMain: ";
+static const string kUsage = "outfilename logfilename [-lines n] [-seed n]"
+                             " [-mix f1 f2 hex ds org] [-labels pct]"
+                             " [-reuse pct] [-comments pct]"
+                             " [-commentlength n] [-errors pct] [-noend]";
+
+/****************************************************************
+ * Print the usage message and stop.
+**/
+static void Usage(char *argv[]) {
+  cout << kTag << "usage: " << argv[0] << " " << kUsage << endl;
+  exit(1);
+}
+
+/****************************************************************
+ * The integer argument after option 'i', or the usage message.
+**/
+static int IntegerArgument(int& i, int argc, char *argv[]) {
+  if (i + 1 >= argc) {
+    Usage(argv);
+  }
+  return Utils::StringToInteger(static_cast<string>(argv[++i]));
+}
+
+int main(int argc, char *argv[]) {
+  string out_filename = "";
+  string log_filename = "";
+  int how_many_lines = 1000;
+  LONG seed = 1;
+
+  ofstream out_stream;
+
+  if (argc < 3) {
+    Usage(argv);
+  }
+  out_filename = static_cast<string>(argv[1]) + ".txt";
+  log_filename = static_cast<string>(argv[2]) + ".txt";
+
+  for (int i = 3; i < argc; ++i) {
+    if (static_cast<string>(argv[i]) == "-seed" && i + 1 < argc) {
+      seed = Utils::StringToLONG(static_cast<string>(argv[i + 1]));
+    }
+  }
+  CorpusGenerator generator(seed);
+
+  for (int i = 3; i < argc; ++i) {
+    string option = static_cast<string>(argv[i]);
+    if (option == "-lines") {
+      how_many_lines = IntegerArgument(i, argc, argv);
+    } else if (option == "-seed") {
+      IntegerArgument(i, argc, argv);
+    } else if (option == "-mix") {
+      int format_one = IntegerArgument(i, argc, argv);
+      int format_two = IntegerArgument(i, argc, argv);
+      int hex = IntegerArgument(i, argc, argv);
+      int ds = IntegerArgument(i, argc, argv);
+      int org = IntegerArgument(i, argc, argv);
+      generator.SetMix(format_one, format_two, hex, ds, org);
+    } else if (option == "-labels") {
+      generator.SetLabelPercent(IntegerArgument(i, argc, argv));
+    } else if (option == "-reuse") {
+      generator.SetReusePercent(IntegerArgument(i, argc, argv));
+    } else if (option == "-comments") {
+      generator.SetCommentPercent(IntegerArgument(i, argc, argv));
+    } else if (option == "-commentlength") {
+      generator.SetCommentLength(IntegerArgument(i, argc, argv));
+    } else if (option == "-errors") {
+      generator.SetErrorPercent(IntegerArgument(i, argc, argv));
+    } else if (option == "-noend") {
+      generator.SetEnd(false);
+    } else {
+      Usage(argv);
+    }
+  }
+
+  Utils::LogFileOpen(log_filename);
+  Utils::FileOpen(out_stream, out_filename);
+
+  Utils::log_stream << kTag << "Beginning execution\n";
+  Utils::log_stream.flush();
+
+  string source = generator.Generate(how_many_lines);
+  out_stream << source;
+  Utils::log_stream << kTag << "wrote " << how_many_lines
+                    << " lines with seed " << seed << endl;
+  if (how_many_lines >= Globals::kMaxMemory) {
+    Utils::log_stream << kTag << "the program is larger than memory" << endl;
+  }
+
+  Utils::log_stream << kTag << "Ending execution\n";
+  Utils::log_stream.flush();
+
+  Utils::FileClose(out_stream);
+  Utils::FileClose(Utils::log_stream);
+
+  return 0;
+}
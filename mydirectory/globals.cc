@@ -10,6 +10,31 @@
  *
 **/
 
+/******************************************************************************
+ * The opcode tables shared by the assembler and the disassembler.
+ * Format I mnemonics are indexed by the three high-order opcode bits; the
+ * opcode '111' marks a Format II instruction, which is identified by its
+ * low-order bits and indexed in the second table.
+**/
+const string Globals::kOpcodeMnemonics[8] = {
+  "BAN", "SUB", "STC", "AND", "ADD", "LD ", "BR ", "   "
+};
+
+const string Globals::kFormatTwoMnemonics[4] = {
+  "   ", "RD ", "STP", "WRT"
+};
+
+/******************************************************************************
+ * The version of the assembler, part of every cache key. Change this
+ * whenever the generated code or the listing changes.
+**/
+const string Globals::kAssemblerVersion = "Pullet16 assembler 6";
+
+/******************************************************************************
+ * The tag at the front of a relocatable object file.
+**/
+const string Globals::kObjectMagic = "P16O";
+
 /******************************************************************************
  * Function 'BitStringToDec'.
  * Convert a bit string to a decimal value.
@@ -47,7 +72,10 @@ string Globals::DecToBitString(int value, const int how_many_bits) const {
 #endif
 
   string bitsetvalue = "";
-  if (how_many_bits == 12) {
+  if (how_many_bits == 3) {
+    bitsetvalue = std::bitset<3>(value).to_string();
+  }
+  else if (how_many_bits == 12) {
     bitsetvalue = std::bitset<12>(value).to_string();
   }
   else if (how_many_bits == 16) {
@@ -63,3 +91,58 @@ string Globals::DecToBitString(int value, const int how_many_bits) const {
 
   return bitsetvalue;
 }
+
+/******************************************************************************
+ * Function 'FormatTwoIndex'.
+ * Look up a Format II mnemonic in the shared table.
+ *
+ * Parameters:
+ *   mnemonic - the three character mnemonic
+ *
+ * Returns:
+ *   the low-order bits for the instruction, or -1 if not Format II
+**/
+int Globals::FormatTwoIndex(const string mnemonic) const {
+  for (int i = 1; i < 4; ++i) {
+    if (kFormatTwoMnemonics[i] == mnemonic) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/******************************************************************************
+ * Function 'HashBytes'.
+ * The 64-bit FNV-1a hash of a string of bytes. Hashes can be chained by
+ * passing the previous hash as the starting value.
+ *
+ * Parameters:
+ *   bytes - the bytes to hash
+ *   hash - the starting value
+**/
+uint64_t Globals::HashBytes(const string& bytes, uint64_t hash) const {
+  for (size_t i = 0; i < bytes.length(); ++i) {
+    hash ^= static_cast<unsigned char>(bytes[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/******************************************************************************
+ * Function 'MnemonicToOpcode'.
+ * Look up a Format I mnemonic in the shared table.
+ *
+ * Parameters:
+ *   mnemonic - the three character mnemonic
+ *
+ * Returns:
+ *   the three-bit opcode, or -1 if not a Format I instruction
+**/
+int Globals::MnemonicToOpcode(const string mnemonic) const {
+  for (int i = 0; i < kFormatTwoOpcode; ++i) {
+    if (kOpcodeMnemonics[i] == mnemonic) {
+      return i;
+    }
+  }
+  return -1;
+}
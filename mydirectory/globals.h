@@ -14,6 +14,7 @@
 #include <iostream>
 #include <string>
 #include <bitset>
+#include <cstdint>
 #include <math.h>
 using namespace std;
 
@@ -24,9 +25,22 @@ using namespace std;
 class Globals {
   public:
     static const int kMaxMemory = 4096;
+    static const uint64_t kHashSeed = 14695981039346656037ULL;
+
+    static const string kAssemblerVersion;
+    static const int kFormatTwoOpcode = 7;
+
+    static const string kObjectMagic;
+    static const int kObjectVersion = 1;
+
+    static const string kOpcodeMnemonics[8];
+    static const string kFormatTwoMnemonics[4];
 
     int BitStringToDec(const string thebits) const;
     string DecToBitString(int value, const int how_many_bits) const;
+    int FormatTwoIndex(const string mnemonic) const;
+    uint64_t HashBytes(const string& bytes, uint64_t hash = kHashSeed) const;
+    int MnemonicToOpcode(const string mnemonic) const;
 
   private:
 };
@@ -0,0 +1,268 @@
+#include "linker.h"
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'Linker' for combining separately assembled object modules.
+ *
+ * Modules are laid out one after another from location zero in the order
+ * they are added. Words listed as relocatable have the module's base added
+ * to their twelve-bit address field, and references to imported symbols
+ * have the field replaced by the symbol's final location.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "Linker: ";
+
+/******************************************************************************
+ * Constructor
+**/
+Linker::Linker() {
+  globals_ = Globals();
+  has_an_error_ = false;
+  next_base_ = 0;
+}
+
+/******************************************************************************
+ * Destructor
+**/
+Linker::~Linker() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'AddModule'.
+ * Read one object file, place it at the next free location, and add its
+ * entry symbols to the global symbol table.
+ *
+ * Parameters:
+ *   object_filename - the object file written by 'WriteObjectFile'
+ *
+ * Returns:
+ *   true if the module was read and placed
+**/
+bool Linker::AddModule(string object_filename) {
+#ifdef EBUG
+  Utils::log_stream << "enter AddModule\n";
+#endif
+
+  ifstream in_stream(object_filename.c_str(), ios::binary);
+  if (in_stream.fail()) {
+    Utils::log_stream << kTag << this->GetErrorMessage("CANNOT OPEN",
+                                                       object_filename) << endl;
+    return false;
+  }
+  string bytes((istreambuf_iterator<char>(in_stream)),
+               istreambuf_iterator<char>());
+
+  size_t magic_length = Globals::kObjectMagic.length();
+  if (bytes.compare(0, magic_length, Globals::kObjectMagic) != 0 ||
+      bytes.length() < magic_length + 10) {
+    Utils::log_stream << kTag << this->GetErrorMessage("NOT AN OBJECT FILE",
+                                                       object_filename) << endl;
+    return false;
+  }
+
+  size_t offset = magic_length;
+  int version = this->GetWord(bytes, offset);
+  int word_count = this->GetWord(bytes, offset);
+  int relocation_count = this->GetWord(bytes, offset);
+  int entry_count = this->GetWord(bytes, offset);
+  int import_count = this->GetWord(bytes, offset);
+
+  size_t expected = offset + 2 * (word_count + relocation_count) +
+                    5 * (entry_count + import_count);
+  if (version != Globals::kObjectVersion || bytes.length() != expected) {
+    Utils::log_stream << kTag << this->GetErrorMessage("BAD OBJECT FILE",
+                                                       object_filename) << endl;
+    return false;
+  }
+
+  if (next_base_ + word_count > Globals::kMaxMemory) {
+    Utils::log_stream << kTag << this->GetErrorMessage("NO ROOM FOR MODULE",
+                                                       object_filename) << endl;
+    return false;
+  }
+
+  Module module;
+  module.name = object_filename;
+  module.base = next_base_;
+
+  module.words.reserve(word_count);
+  for (int i = 0; i < word_count; ++i) {
+    module.words.push_back(this->GetWord(bytes, offset));
+  }
+  for (int i = 0; i < relocation_count; ++i) {
+    module.relocations.push_back(this->GetWord(bytes, offset));
+  }
+  for (int i = 0; i < entry_count; ++i) {
+    string symbol = bytes.substr(offset, 3);
+    offset += 3;
+    module.entries.push_back(make_pair(symbol, this->GetWord(bytes, offset)));
+  }
+  for (int i = 0; i < import_count; ++i) {
+    string symbol = bytes.substr(offset, 3);
+    offset += 3;
+    module.imports.push_back(make_pair(symbol, this->GetWord(bytes, offset)));
+  }
+
+  for (auto it = module.entries.begin(); it != module.entries.end(); ++it) {
+    if (symboltable_.count(it->first) != 0) {
+      Utils::log_stream << kTag << this->GetErrorMessage("SYMBOL "
+                           + it->first + " IS MULTIPLY DEFINED IN",
+                           object_filename) << endl;
+    } else {
+      symboltable_[it->first] = module.base + it->second;
+    }
+  }
+
+  next_base_ += word_count;
+  modules_.push_back(module);
+
+#ifdef EBUG
+  Utils::log_stream << "leave AddModule\n";
+#endif
+  return true;
+}
+
+/******************************************************************************
+ * Function 'GetErrorMessage'.
+ * This creates an error message and notes that the link has failed.
+ *
+ * Parameters:
+ *   leadingtext - the text of what it is that is wrong
+ *   badtext - the symbol or file name at fault
+**/
+string Linker::GetErrorMessage(string leadingtext, string badtext) {
+  has_an_error_ = true;
+  return "***** ERROR -- " + leadingtext + " " + badtext;
+}
+
+/******************************************************************************
+ * Function 'GetWord'.
+ * Read one 16-bit little-endian word from an object file image.
+ *
+ * Parameters:
+ *   bytes - the contents of the object file
+ *   offset - the position to read from, advanced past the word
+**/
+int Linker::GetWord(const string& bytes, size_t& offset) const {
+  int value = static_cast<unsigned char>(bytes[offset]) +
+              256 * static_cast<unsigned char>(bytes[offset + 1]);
+  offset += 2;
+  return value;
+}
+
+/******************************************************************************
+ * Function 'Link'.
+ * Patch the address fields of every module, write the memory image, and
+ * write a link map of the module bases and the global symbol table.
+ *
+ * Parameters:
+ *   binary_filename - the '.bin' file to write
+ *   out_stream - the output stream for the link map
+ *
+ * Returns:
+ *   true if the link succeeded and the image was written
+**/
+bool Linker::Link(string binary_filename, ofstream& out_stream) {
+#ifdef EBUG
+  Utils::log_stream << "enter Link\n";
+#endif
+
+  string s = "LINK MAP\n    MODULE BASE SIZE\n";
+  vector<int> image(next_base_, 0);
+
+  for (auto module = modules_.begin(); module != modules_.end(); ++module) {
+    int base = module->base;
+    int size = module->words.size();
+
+    s += "MOD " + module->name + " " + Utils::Format(base) + " "
+                + Utils::Format(size) + "\n";
+
+    for (int i = 0; i < size; ++i) {
+      image[base + i] = module->words.at(i);
+    }
+
+    for (auto it = module->relocations.begin();
+         it != module->relocations.end(); ++it) {
+      if (*it >= size) {
+        s += this->GetErrorMessage("BAD RELOCATION IN", module->name) + "\n";
+        continue;
+      }
+      int word = image[base + *it];
+      int address = (word & 0xFFF) + base;
+      if (address >= Globals::kMaxMemory) {
+        s += this->GetErrorMessage("ADDRESS OUT OF RANGE IN",
+                                   module->name) + "\n";
+        continue;
+      }
+      image[base + *it] = (word & 0xF000) | address;
+    }
+
+    for (auto it = module->imports.begin(); it != module->imports.end(); ++it) {
+      auto found = symboltable_.find(it->first);
+      if (found == symboltable_.end()) {
+        s += this->GetErrorMessage("SYMBOL " + it->first + " IS UNDEFINED IN",
+                                   module->name) + "\n";
+      } else if (it->second >= size) {
+        s += this->GetErrorMessage("BAD IMPORT IN", module->name) + "\n";
+      } else {
+        int word = image[base + it->second];
+        image[base + it->second] = (word & 0xF000) | found->second;
+      }
+    }
+  }
+
+  s += "\n SYMBOL TABLE\n    SYM LOC\n";
+  for (auto it = symboltable_.begin(); it != symboltable_.end(); ++it) {
+    s += "SYM " + it->first + " " + Utils::Format(it->second) + "\n";
+  }
+
+  if (has_an_error_) {
+    s += "\n***** ERROR -- LINK FAILED, NO BINARY FILE WRITTEN\n";
+  } else {
+    this->WriteBinaryFile(binary_filename, image);
+  }
+
+  out_stream << s << endl;
+  Utils::log_stream << s << endl;
+
+#ifdef EBUG
+  Utils::log_stream << "leave Link\n";
+#endif
+  return !has_an_error_;
+}
+
+/******************************************************************************
+ * Function 'WriteBinaryFile'.
+ * Writes the linked memory image in the same form as the assembler.
+ *
+ * Parameters:
+ *   binary_filename - the '.bin' file to write
+ *   image - the linked memory image
+**/
+void Linker::WriteBinaryFile(string binary_filename, const vector<int>& image) {
+  FILE *fp = fopen(binary_filename.c_str(), "w");
+  if (fp == NULL) {
+    Utils::log_stream << kTag << this->GetErrorMessage("CANNOT OPEN",
+                                                       binary_filename) << endl;
+    return;
+  }
+
+  for (auto it = image.begin(); it != image.end(); ++it) {
+    short machine_binary = static_cast<short>(*it);
+    fwrite(&machine_binary, 2, 1, fp);
+  }
+
+  fclose(fp);
+}
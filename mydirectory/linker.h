@@ -0,0 +1,54 @@
+/****************************************************************
+ * Header file for the Pullet16 linker.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef LINKER_H
+#define LINKER_H
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../../Utilities/utils.h"
+
+#include "globals.h"
+
+class Linker {
+  public:
+    Linker();
+    virtual ~Linker();
+
+    bool AddModule(string object_filename);
+    bool Link(string binary_filename, ofstream& out_stream);
+
+  private:
+    struct Module {
+      string name;
+      int base;
+      vector<int> words;
+      vector<int> relocations;
+      vector<pair<string, int> > entries;
+      vector<pair<string, int> > imports;
+    };
+
+    bool has_an_error_;
+    int next_base_;
+    vector<Module> modules_;
+    map<string, int> symboltable_;
+
+    Globals globals_;
+
+    string GetErrorMessage(string leadingtext, string badtext);
+    int GetWord(const string& bytes, size_t& offset) const;
+    void WriteBinaryFile(string binary_filename, const vector<int>& image);
+};
+
+#endif
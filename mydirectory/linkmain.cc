@@ -0,0 +1,53 @@
+#include "linker.h"
+
+/****************************************************************
+ * Main program for Pullet Linker program.
+ *
+ * Author/copyright:  Duncan Buell. All rights reserved.
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+ * Note that all file names are entered without extensions.
+ * The object files are linked in the order given.
+**/
+
+static const string kTag = "LinkMain: ";
+
+int main(int argc, char *argv[]) {
+  string binary_filename = "";
+  string out_filename = "";
+  string log_filename = "";
+
+  ofstream out_stream;
+
+  Linker linker;
+
+  if (argc < 4) {
+    cout << kTag << "usage: " << argv[0]
+         << " outfilename logfilename objfilename ..." << endl;
+    exit(1);
+  }
+  binary_filename = static_cast<string>(argv[1]) + ".bin";
+  out_filename = static_cast<string>(argv[1]) + ".txt";
+  log_filename = static_cast<string>(argv[2]) + ".txt";
+
+  Utils::LogFileOpen(log_filename);
+  Utils::FileOpen(out_stream, out_filename);
+
+  Utils::log_stream << kTag << "Beginning execution\n";
+  Utils::log_stream.flush();
+
+  bool linked = true;
+  for (int i = 3; i < argc; ++i) {
+    linked = linker.AddModule(static_cast<string>(argv[i]) + ".obj") && linked;
+  }
+  linked = linker.Link(binary_filename, out_stream) && linked;
+
+  Utils::log_stream << kTag << "Ending execution\n";
+  Utils::log_stream.flush();
+
+  Utils::FileClose(out_stream);
+  Utils::FileClose(Utils::log_stream);
+
+  return linked ? 0 : 1;
+}
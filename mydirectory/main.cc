@@ -8,29 +8,93 @@
  * Date: 4 December 2017
  *
  * Note that all file names are entered without extensions.
+ *
+ * Options may follow the three file names:
+ *   -obj  also write a relocatable object file 'outfilename.obj'
+ *   -cache dir  reuse results for identical sources from 'dir'
+ *   -cachemax mb  cap the cache directory at 'mb' megabytes (default 64)
+ *   -report  write the time and resources of each phase as JSON to
+ *            'outfilename.json'
+ *   -inc  re-encode only the lines changed since the last run, using
+ *         the sidecar file 'outfilename.inc'
+ *   -stream  assemble in one pass in memory that does not grow with the
+ *            length of the source; not with -obj, -cache, or -inc
+ *   -readahead  read the source on a background thread, ahead of the
+ *               assembler, for slow or networked filesystems
 **/
 
 static const string kTag = "Main: ";
+static const string kUsage = "infilename outfilename logfilename [-obj]"
+                             " [-cache dir [-cachemax mb]] [-inc] [-report]"
+                             " [-stream] [-readahead]";
+
+/****************************************************************
+ * Print the usage message and stop.
+**/
+static void Usage(char *argv[]) {
+  cout << kTag << "usage: " << argv[0] << " " << kUsage << endl;
+  exit(1);
+}
 
 int main(int argc, char *argv[]) {
   string in_filename = "";
   string binary_filename = "";
+  string object_filename = "";
   string out_filename = "";
   string log_filename = "";
+  string cache_directory = "";
+  string report_filename = "";
+  long cache_max_megabytes = 64;
+  bool is_incremental = false;
+  bool is_read_ahead = false;
+  bool is_streaming = false;
 
   Scanner in_scanner;
   ofstream out_stream;
 
   Assembler assembler;
 
-  Utils::CheckArgs(3, argc, argv, "infilename outfilename logfilename");
+  if (argc < 4) {
+    Usage(argv);
+  }
   in_filename = static_cast<string>(argv[1]) + ".txt";
   binary_filename = static_cast<string>(argv[2]) + ".bin";
   out_filename = static_cast<string>(argv[2]) + ".txt";
   log_filename = static_cast<string>(argv[3]) + ".txt";
 
+  for (int i = 4; i < argc; ++i) {
+    string option = static_cast<string>(argv[i]);
+    if (option == "-obj") {
+      object_filename = static_cast<string>(argv[2]) + ".obj";
+    } else if (option == "-report") {
+      report_filename = static_cast<string>(argv[2]) + ".json";
+      assembler.SetReport(true);
+    } else if (option == "-inc") {
+      assembler.SetIncremental(static_cast<string>(argv[2]) + ".inc");
+      is_incremental = true;
+    } else if (option == "-stream") {
+      is_streaming = true;
+    } else if (option == "-readahead") {
+      is_read_ahead = true;
+    } else if (option == "-cache" && i + 1 < argc) {
+      cache_directory = static_cast<string>(argv[++i]);
+    } else if (option == "-cachemax" && i + 1 < argc) {
+      cache_max_megabytes = Utils::StringToLONG(static_cast<string>(argv[++i]));
+    } else {
+      Usage(argv);
+    }
+  }
+  if (is_streaming && (object_filename != "" || cache_directory != "" ||
+                       is_incremental)) {
+    Usage(argv);
+  }
+
   Utils::LogFileOpen(log_filename);
-  in_scanner.OpenFile(in_filename);
+  if (is_read_ahead) {
+    in_scanner.OpenFileReadAhead(in_filename);
+  } else {
+    in_scanner.OpenFile(in_filename);
+  }
   Utils::FileOpen(out_stream, out_filename);
 
   Utils::log_stream << kTag << "Beginning execution\n";
@@ -38,7 +102,39 @@ int main(int argc, char *argv[]) {
 
   Utils::log_stream << kTag << "logfile '" << log_filename << "'\n";
 
-  assembler.Assemble(in_scanner, binary_filename, out_stream);
+  if (is_streaming) {
+    assembler.AssembleStreaming(in_scanner, binary_filename, out_stream);
+  } else if (cache_directory == "") {
+    assembler.Assemble(in_scanner, binary_filename, out_stream);
+    if (object_filename != "") {
+      assembler.WriteObjectFile(object_filename);
+    }
+  } else {
+    AssemblyCache cache(cache_directory, cache_max_megabytes * 1024 * 1024);
+    string source = "";
+    cache.ReadFile(in_filename, source);
+    if (!cache.Fetch(source, binary_filename, object_filename, out_stream)) {
+      assembler.Assemble(in_scanner, binary_filename, out_stream);
+      if (object_filename != "") {
+        assembler.WriteObjectFile(object_filename);
+      }
+      out_stream.flush();
+      // The key covers only the main source, not the files it includes.
+      if (!assembler.UsesIncludes()) {
+        cache.Store(source, binary_filename, object_filename, out_filename);
+      }
+    }
+  }
+
+  if (report_filename != "") {
+    assembler.WriteReport(report_filename);
+  }
+
+#ifdef ALLOCTRACK
+  string allocation_summary = AllocTracker::Summary();
+  cout << allocation_summary;
+  Utils::log_stream << allocation_summary;
+#endif
 
   Utils::log_stream << kTag << "Ending execution\n";
   Utils::log_stream.flush();
@@ -47,4 +143,3 @@ int main(int argc, char *argv[]) {
 
   return 0;
 }
-
@@ -17,6 +17,7 @@ using namespace std;
 #include "../../Utilities/scanner.h"
 #include "../../Utilities/scanline.h"
 
+#include "assemblycache.h"
 #include "pullet16assembler.h"
 
 #endif // MAIN_H
@@ -0,0 +1,204 @@
+#include "phasereport.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include <sys/resource.h>
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'PhaseReport' for recording what each phase of an assembly costs.
+ *
+ * 'Begin' samples the clocks and 'End' turns the samples into the time
+ * spent in the phase, so phases may nest; each phase keeps its depth.
+ * Wall time comes from the steady clock, user and system time and peak
+ * resident set size from 'getrusage'. The peak is for the process as a
+ * whole when the phase ends. All state is in the object, so separate
+ * assemblers can keep separate reports.
+ *
+ * When the report is not enabled 'Begin' and 'End' do nothing, except
+ * to mark the phases for the allocation tracker in an 'ALLOCTRACK' build.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "PhaseReport: ";
+
+/******************************************************************************
+ * Constructor
+**/
+PhaseReport::PhaseReport() {
+  is_enabled_ = false;
+  depth_ = 0;
+}
+
+/******************************************************************************
+ * Destructor
+**/
+PhaseReport::~PhaseReport() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * Mutator 'Clear'.
+ * Forget the phases recorded so far.
+**/
+void PhaseReport::Clear() {
+  depth_ = 0;
+  phases_.clear();
+}
+
+/******************************************************************************
+ * Accessor 'IsEnabled'.
+**/
+bool PhaseReport::IsEnabled() const {
+  return is_enabled_;
+}
+
+/******************************************************************************
+ * Mutator 'SetEnabled'.
+**/
+void PhaseReport::SetEnabled(bool is_enabled) {
+  is_enabled_ = is_enabled;
+}
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'Begin'.
+ * Start timing a phase.
+ *
+ * Parameters:
+ *   name - the name of the phase
+ *
+ * Returns:
+ *   the number to pass to 'End', or -1 if the report is not enabled
+**/
+int PhaseReport::Begin(string name) {
+#ifdef ALLOCTRACK
+  AllocTracker::Begin(name);
+#endif
+
+  if (!is_enabled_) {
+    return -1;
+  }
+
+  Phase phase;
+  phase.name = name;
+  phase.depth = depth_;
+  phase.lines = 0;
+  phase.words = 0;
+  phase.bytes = 0;
+  this->Sample(phase.wall_ns, phase.user_us, phase.system_us,
+               phase.peak_rss_kb);
+  phases_.push_back(phase);
+
+  ++depth_;
+  return phases_.size() - 1;
+}
+
+/******************************************************************************
+ * Function 'End'.
+ * Finish timing a phase.
+ *
+ * Parameters:
+ *   phase - the number returned by 'Begin'
+ *   lines - the source lines the phase handled
+ *   words - the words of machine code the phase produced
+ *   bytes - the bytes the phase wrote
+**/
+void PhaseReport::End(int phase, long lines, long words, long bytes) {
+#ifdef ALLOCTRACK
+  AllocTracker::End();
+#endif
+
+  if (!is_enabled_ || phase < 0 || phase >= static_cast<int>(phases_.size())) {
+    return;
+  }
+
+  uint64_t wall_ns = 0;
+  uint64_t user_us = 0;
+  uint64_t system_us = 0;
+  long peak_rss_kb = 0;
+  this->Sample(wall_ns, user_us, system_us, peak_rss_kb);
+
+  Phase& entry = phases_.at(phase);
+  entry.wall_ns = wall_ns - entry.wall_ns;
+  entry.user_us = user_us - entry.user_us;
+  entry.system_us = system_us - entry.system_us;
+  entry.peak_rss_kb = peak_rss_kb;
+  entry.lines = lines;
+  entry.words = words;
+  entry.bytes = bytes;
+
+  --depth_;
+}
+
+/******************************************************************************
+ * Function 'Sample'.
+ * Read the clocks and the peak resident set size.
+**/
+void PhaseReport::Sample(uint64_t& wall_ns, uint64_t& user_us,
+                         uint64_t& system_us, long& peak_rss_kb) const {
+  wall_ns = chrono::duration_cast<chrono::nanoseconds>(
+              chrono::steady_clock::now().time_since_epoch()).count();
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  user_us = usage.ru_utime.tv_sec * 1000000ULL + usage.ru_utime.tv_usec;
+  system_us = usage.ru_stime.tv_sec * 1000000ULL + usage.ru_stime.tv_usec;
+  peak_rss_kb = usage.ru_maxrss;
+}
+
+/******************************************************************************
+ * Function 'ToJson'.
+ * Format the phases as a JSON object, in the order they began.
+**/
+string PhaseReport::ToJson() const {
+  string s = "{\n  \"phases\": [";
+
+  for (size_t i = 0; i < phases_.size(); ++i) {
+    const Phase& phase = phases_.at(i);
+    s += (i == 0) ? "\n" : ",\n";
+    s += "    {\"name\": \"" + phase.name + "\""
+       + ", \"depth\": " + to_string(phase.depth)
+       + ", \"wall_ns\": " + to_string(phase.wall_ns)
+       + ", \"user_us\": " + to_string(phase.user_us)
+       + ", \"system_us\": " + to_string(phase.system_us)
+       + ", \"peak_rss_kb\": " + to_string(phase.peak_rss_kb)
+       + ", \"lines\": " + to_string(phase.lines)
+       + ", \"words\": " + to_string(phase.words)
+       + ", \"bytes\": " + to_string(phase.bytes) + "}";
+  }
+
+  s += "\n  ]\n}\n";
+  return s;
+}
+
+/******************************************************************************
+ * Function 'Write'.
+ * Write the JSON report to a file.
+ *
+ * Returns:
+ *   true if the file was written
+**/
+bool PhaseReport::Write(string report_filename) const {
+  FILE *fp = fopen(report_filename.c_str(), "w");
+  if (fp == NULL) {
+    Utils::log_stream << kTag << "open failed for '"
+                      << report_filename << "'" << endl;
+    return false;
+  }
+
+  string s = this->ToJson();
+  fwrite(s.data(), 1, s.size(), fp);
+  fclose(fp);
+  return true;
+}
@@ -0,0 +1,59 @@
+/****************************************************************
+ * Header file for the 'PhaseReport' class, which times the phases of
+ * an assembly and writes the figures as JSON.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef PHASEREPORT_H
+#define PHASEREPORT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+#include "../../Utilities/utils.h"
+
+#include "alloctracker.h"
+
+class PhaseReport {
+  public:
+    PhaseReport();
+    virtual ~PhaseReport();
+
+    void Clear();
+    bool IsEnabled() const;
+    void SetEnabled(bool is_enabled);
+
+    int Begin(string name);
+    void End(int phase, long lines, long words, long bytes);
+    string ToJson() const;
+    bool Write(string report_filename) const;
+
+  private:
+    struct Phase {
+      string name;
+      int depth;
+      uint64_t wall_ns;
+      uint64_t user_us;
+      uint64_t system_us;
+      long peak_rss_kb;
+      long lines;
+      long words;
+      long bytes;
+    };
+
+    bool is_enabled_;
+    int depth_;
+    vector<Phase> phases_;
+
+    void Sample(uint64_t& wall_ns, uint64_t& user_us, uint64_t& system_us,
+                long& peak_rss_kb) const;
+};
+
+#endif
@@ -0,0 +1,359 @@
+#include "preprocessor.h"
+
+/******************************************************************************
+ *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
+ * Class 'Preprocessor' for macros and include files.
+ *
+ * A macro is defined by a 'MAC' line with the macro name in the label
+ * columns, then the body, then an 'MND' line. It is called by putting
+ * its name in the mnemonic columns and the arguments, separated by
+ * commas, from column 10 on:
+ *
+ *   ADN MAC
+ *       LD    &1
+ *       ADD   &2
+ *       STC   &1
+ *       MND
+ *   ...
+ *   TOP ADN   IDX,ONE
+ *
+ * A label, symbolic operand, or hex operand field that starts with '&1'
+ * through '&9' is replaced by that argument. An argument for the symbolic
+ * operand may be an expression of up to nine characters. A label on the
+ * call goes on the first line of the body. Bodies may call other macros.
+ *
+ * The body is expanded once for each distinct list of arguments and
+ * kept, and later calls with the same arguments read the kept lines in
+ * place through a 'View' instead of expanding the text again.
+ *
+ * 'INC' takes a file name, without extension, from column 10 and reads
+ * that file in place of the line.
+ *
+ * Author: Duncan A. Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+**/
+
+static const string kTag = "Preprocessor: ";
+static const int kMaxDepth = 8;
+
+/******************************************************************************
+ * Constructor
+ *
+ * Parameters:
+ *   in_scanner - the scanner for the main source file
+ *   mnemonics - the real mnemonics, which a macro may not redefine
+**/
+Preprocessor::Preprocessor(Scanner& in_scanner, const set<string>& mnemonics)
+  : in_scanner_(in_scanner), mnemonics_(mnemonics) {
+  linecounter_ = 0;
+  uses_includes_ = false;
+}
+
+/******************************************************************************
+ * Destructor
+**/
+Preprocessor::~Preprocessor() {
+}
+
+/******************************************************************************
+ * Accessors and Mutators
+**/
+
+/******************************************************************************
+ * Accessor 'GetErrorMessages'.
+**/
+vector<string> Preprocessor::GetErrorMessages() const {
+  return error_messages_;
+}
+
+/******************************************************************************
+ * Accessor 'HasAnError'.
+**/
+bool Preprocessor::HasAnError() const {
+  return !error_messages_.empty();
+}
+
+/******************************************************************************
+ * Accessor 'UsesIncludes'.
+ * True once an 'INC' line has been read, whether or not the file opened.
+**/
+bool Preprocessor::UsesIncludes() const {
+  return uses_includes_;
+}
+
+/******************************************************************************
+ * General functions.
+**/
+
+/******************************************************************************
+ * Function 'AddError'.
+ * Record an error against the current line of the main file.
+**/
+void Preprocessor::AddError(string message) {
+  string s = "***** ERROR -- " + message + " AT LINE "
+           + Utils::Format(linecounter_);
+  Utils::log_stream << kTag << s << endl;
+  error_messages_.push_back(s);
+}
+
+/******************************************************************************
+ * Function 'DefineMacro'.
+ * Read a macro body up to its 'MND' line.
+ *
+ * Parameters:
+ *   name - the three character name of the macro
+**/
+void Preprocessor::DefineMacro(string name) {
+  bool is_valid = true;
+  if (name == "   " || mnemonics_.count(name) != 0 ||
+      name == "MAC" || name == "MND" || name == "INC") {
+    this->AddError("INVALID MACRO NAME '" + name + "'");
+    is_valid = false;
+  } else if (macros_.count(name) != 0) {
+    this->AddError("MACRO '" + name + "' ALREADY DEFINED");
+    is_valid = false;
+  }
+
+  vector<string> body;
+  string line = this->NextRawLine();
+  while (line.length() > 0 && this->Field(line, 4, 3) != "MND") {
+    if (this->Field(line, 4, 3) == "MAC") {
+      this->AddError("MACRO DEFINED INSIDE MACRO '" + name + "'");
+    } else if (line.substr(0, 1) != "*") {
+      body.push_back(line);
+    }
+    line = this->NextRawLine();
+  }
+  if (line.length() == 0) {
+    this->AddError("NO 'MND' FOR MACRO '" + name + "'");
+  }
+
+  if (is_valid) {
+    macros_[name] = body;
+  }
+}
+
+/******************************************************************************
+ * Function 'Expand'.
+ * The lines of a macro call, from the kept expansions if this list of
+ * arguments has been seen before.
+ *
+ * Parameters:
+ *   name - the macro
+ *   args - the arguments of the call
+ *   depth - how deeply calls are nested
+**/
+Preprocessor::Lines Preprocessor::Expand(string name,
+                                         const vector<string>& args,
+                                         int depth) {
+  string key = name;
+  for (auto it = args.begin(); it != args.end(); ++it) {
+    key += '\0' + *it;
+  }
+  auto found = expansions_.find(key);
+  if (found != expansions_.end()) {
+    return found->second;
+  }
+
+  shared_ptr<vector<string> > lines = make_shared<vector<string> >();
+  if (depth > kMaxDepth) {
+    this->AddError("MACROS NESTED TOO DEEPLY IN '" + name + "'");
+    return lines;
+  }
+
+  const vector<string>& body = macros_[name];
+  for (auto it = body.begin(); it != body.end(); ++it) {
+    string line = this->Substitute(*it, args);
+    if (!this->IsMacroCall(line)) {
+      lines->push_back(line);
+      continue;
+    }
+
+    Lines inner = this->Expand(this->Field(line, 4, 3),
+                               this->SplitArgs(line), depth + 1);
+    for (size_t i = 0; i < inner->size(); ++i) {
+      string inner_line = inner->at(i);
+      if (i == 0 && this->Field(line, 0, 3) != "   ") {
+        if (this->Field(inner_line, 0, 3) != "   ") {
+          this->AddError("LABEL ON CALL OF '" + this->Field(line, 4, 3)
+                         + "' CLASHES WITH ITS FIRST LINE");
+        }
+        inner_line.replace(0, 3, this->Field(line, 0, 3));
+      }
+      lines->push_back(inner_line);
+    }
+  }
+
+  expansions_[key] = lines;
+  return lines;
+}
+
+/******************************************************************************
+ * Function 'Field'.
+ * The fixed columns of a line, padded with blanks if the line is short.
+**/
+string Preprocessor::Field(const string& line, size_t start,
+                           size_t width) const {
+  string s = (start < line.length()) ? line.substr(start, width) : "";
+  if (s.length() < width) {
+    s += string(width - s.length(), ' ');
+  }
+  return s;
+}
+
+/******************************************************************************
+ * Function 'IsMacroCall'.
+ * Whether the mnemonic columns of a line name a defined macro.
+**/
+bool Preprocessor::IsMacroCall(const string& line) const {
+  if (line.substr(0, 1) == "*") {
+    return false;
+  }
+  return macros_.count(this->Field(line, 4, 3)) != 0;
+}
+
+/******************************************************************************
+ * Function 'NextLine'.
+ * This top level function returns the next line for pass one, with the
+ * same end of file convention as 'Scanner::NextLine'.
+**/
+string Preprocessor::NextLine() {
+  while (true) {
+    while (!views_.empty() &&
+           views_.back().next >= views_.back().lines->size()) {
+      views_.pop_back();
+    }
+    if (!views_.empty()) {
+      return views_.back().lines->at(views_.back().next++);
+    }
+
+    string line = this->NextRawLine();
+    if (line.length() == 0 || line.substr(0, 1) == "*") {
+      return line;
+    }
+
+    string mnemonic = this->Field(line, 4, 3);
+    if (mnemonic == "MAC") {
+      this->DefineMacro(this->Field(line, 0, 3));
+    } else if (mnemonic == "MND") {
+      this->AddError("'MND' WITHOUT 'MAC'");
+    } else if (mnemonic == "INC") {
+      uses_includes_ = true;
+      string filename = this->Field(line, 10, line.length());
+      filename = filename.substr(0, filename.find(' ')) + ".txt";
+      shared_ptr<ifstream> in_stream = make_shared<ifstream>(filename.c_str());
+      if (in_stream->fail()) {
+        this->AddError("CANNOT INCLUDE '" + filename + "'");
+      } else if (includes_.size() >= static_cast<size_t>(kMaxDepth)) {
+        this->AddError("INCLUDES NESTED TOO DEEPLY AT '" + filename + "'");
+      } else {
+        includes_.push_back(in_stream);
+      }
+    } else if (this->IsMacroCall(line)) {
+      View view;
+      view.lines = this->Expand(mnemonic, this->SplitArgs(line), 0);
+      view.next = 0;
+      if (view.lines->empty()) {
+        continue;
+      }
+      string label = this->Field(line, 0, 3);
+      if (label != "   ") {
+        string first_line = view.lines->at(0);
+        if (this->Field(first_line, 0, 3) != "   ") {
+          this->AddError("LABEL ON CALL OF '" + mnemonic
+                         + "' CLASHES WITH ITS FIRST LINE");
+        }
+        first_line.replace(0, 3, label);
+        view.next = 1;
+        views_.push_back(view);
+        return first_line;
+      }
+      views_.push_back(view);
+    } else {
+      return line;
+    }
+  }
+}
+
+/******************************************************************************
+ * Function 'NextRawLine'.
+ * The next line of text, from the innermost include file or else from
+ * the main file. An include file ends where the main file would.
+**/
+string Preprocessor::NextRawLine() {
+  while (!includes_.empty()) {
+    string line = "";
+    if (getline(*includes_.back(), line) && line.length() > 0) {
+      return line;
+    }
+    includes_.pop_back();
+  }
+
+  //Comments never reach pass one, so the scanner may pass over them.
+  linecounter_ += in_scanner_.SkipCommentLines();
+  ++linecounter_;
+  return in_scanner_.NextLine();
+}
+
+/******************************************************************************
+ * Function 'SplitArgs'.
+ * The comma separated arguments of a macro call, from column 10 to the
+ * first blank.
+**/
+vector<string> Preprocessor::SplitArgs(const string& line) const {
+  vector<string> args;
+  string text = this->Field(line, 10, line.length());
+  text = text.substr(0, text.find(' '));
+  if (text.length() == 0) {
+    return args;
+  }
+
+  size_t start = 0;
+  size_t comma = text.find(',');
+  while (comma != string::npos) {
+    args.push_back(text.substr(start, comma - start));
+    start = comma + 1;
+    comma = text.find(',', start);
+  }
+  args.push_back(text.substr(start));
+  return args;
+}
+
+/******************************************************************************
+ * Function 'Substitute'.
+ * Replace the parameters in the label, symbolic operand, and hex operand
+ * fields of one body line.
+**/
+string Preprocessor::Substitute(string line, const vector<string>& args) {
+  static const size_t kStarts[3] = {0, 10, 14};
+  static const size_t kWidths[3] = {3, 3, 5};
+
+  for (int i = 0; i < 3; ++i) {
+    string field = this->Field(line, kStarts[i], kWidths[i]);
+    if (field[0] != '&' || field[1] < '1' || field[1] > '9') {
+      continue;
+    }
+
+    size_t which = field[1] - '1';
+    string arg = "";
+    if (which < args.size()) {
+      arg = args.at(which);
+    } else {
+      this->AddError("MISSING MACRO ARGUMENT '" + field.substr(0, 2) + "'");
+    }
+    //An expression argument for the symbolic operand runs on through
+    //the hex operand columns.
+    size_t width = kWidths[i];
+    if (i == 1 && arg.length() > width) {
+      width = 9;
+    }
+    arg.resize(width, ' ');
+
+    if (line.length() < kStarts[i] + width) {
+      line.resize(kStarts[i] + width, ' ');
+    }
+    line.replace(kStarts[i], width, arg);
+  }
+  return line;
+}
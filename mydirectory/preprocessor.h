@@ -0,0 +1,66 @@
+/****************************************************************
+ * Header file for the 'Preprocessor' class, which expands macros and
+ * include files ahead of pass one.
+ *
+ * Author/copyright:  Duncan Buell
+ * Used with permission and modified by: Katherine Haberlin
+ * Date: 4 December 2017
+ *
+**/
+
+#ifndef PREPROCESSOR_H
+#define PREPROCESSOR_H
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../../Utilities/scanner.h"
+#include "../../Utilities/utils.h"
+
+class Preprocessor {
+  public:
+    Preprocessor(Scanner& in_scanner, const set<string>& mnemonics);
+    virtual ~Preprocessor();
+
+    vector<string> GetErrorMessages() const;
+    bool HasAnError() const;
+    bool UsesIncludes() const;
+
+    string NextLine();
+
+  private:
+    typedef shared_ptr<const vector<string> > Lines;
+
+    struct View {
+      Lines lines;
+      size_t next;
+    };
+
+    bool uses_includes_;
+    int linecounter_;
+    Scanner& in_scanner_;
+    const set<string>& mnemonics_;
+
+    map<string, vector<string> > macros_;
+    map<string, Lines> expansions_;
+    vector<View> views_;
+    vector<shared_ptr<ifstream> > includes_;
+    vector<string> error_messages_;
+
+    void AddError(string message);
+    void DefineMacro(string name);
+    Lines Expand(string name, const vector<string>& args, int depth);
+    string Field(const string& line, size_t start, size_t width) const;
+    bool IsMacroCall(const string& line) const;
+    string NextRawLine();
+    vector<string> SplitArgs(const string& line) const;
+    string Substitute(string line, const vector<string>& args);
+};
+
+#endif
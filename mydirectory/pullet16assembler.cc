@@ -1,5 +1,38 @@
 #include "pullet16assembler.h"
 
+static const string kSidecarMagic = "P16I";
+
+/******************************************************************************
+ * Helpers to pack and unpack the incremental sidecar file.
+**/
+static void PutValue(string& s, uint64_t value) {
+  s.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void PutString(string& s, const string& value) {
+  PutValue(s, value.length());
+  s += value;
+}
+
+static bool GetValue(const string& s, size_t& offset, uint64_t& value) {
+  if (offset + sizeof(value) > s.length()) {
+    return false;
+  }
+  s.copy(reinterpret_cast<char *>(&value), sizeof(value), offset);
+  offset += sizeof(value);
+  return true;
+}
+
+static bool GetString(const string& s, size_t& offset, string& value) {
+  uint64_t length = 0;
+  if (!GetValue(s, offset, length) || offset + length > s.length()) {
+    return false;
+  }
+  value = s.substr(offset, length);
+  offset += length;
+  return true;
+}
+
 /******************************************************************************
  *3456789 123456789 123456789 123456789 123456789 123456789 123456789 123456789
  * Class 'Assembler' for assembling code.
@@ -14,7 +47,8 @@
 **/
 Assembler::Assembler() {
   globals_ = Globals();
-
+  sidecar_filename_ = "";
+  this->Reset();
 }
 
 /******************************************************************************
@@ -27,25 +61,236 @@ Assembler::~Assembler() {
  * Accessors and Mutators
 **/
 
+/******************************************************************************
+ * Accessor 'GetBinaryImage'.
+ * The bytes of the '.bin' file for the last assembly, as
+ * 'WriteBinaryFile' writes them.
+**/
+string Assembler::GetBinaryImage() {
+  string image = "";
+  int size = machinecode_.size();
+  for (int i = 0; i < size; ++i) {
+    string machine_string = machinecode_[i];
+    int machine_decimal = globals_.BitStringToDec(machine_string);
+    short machine_binary = static_cast<short>(machine_decimal);
+    image.append(reinterpret_cast<const char *>(&machine_binary), 2);
+  }
+  return image;
+}
+
+/******************************************************************************
+ * Accessor 'GetObjectImage'.
+ * The bytes of the object file for the last assembly, as
+ * 'WriteObjectFile' writes them.
+ *
+ * Parameters:
+ *   image - the bytes, empty if there is no object file
+ *
+ * Returns:
+ *   true if the module assembled cleanly and can be linked
+**/
+bool Assembler::GetObjectImage(string& image) {
+  image = "";
+  if (has_an_error_ || !found_end_statement_) {
+    Utils::log_stream << "NO OBJECT FILE WRITTEN FOR A PROGRAM WITH ERRORS\n";
+    return false;
+  }
+
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (symboltable_.count(*it) == 0) {
+      Utils::log_stream << "***** ERROR -- ENTRY " << *it
+                        << " IS UNDEFINED" << endl;
+      this->GetUndefinedMessage(*it);
+      return false;
+    }
+  }
+
+  //Format I words that name a local address are relocated,
+  //those that name an imported symbol are patched by the linker.
+  //An expression must be a plain number or one address plus a number.
+  vector<int> relocations;
+  vector<pair<int, string> > imports;
+  for (auto it = codelines_.begin(); it != codelines_.end(); ++it) {
+    if (it->GetMnemonic() == "END") {
+      break;
+    }
+    string symoperand = it->GetSymOperand();
+    if (globals_.MnemonicToOpcode(it->GetMnemonic()) < 0) {
+      continue;
+    }
+    if (it->HasExpression()) {
+      const Expression& expression = it->GetExpression();
+      if (expression.IsRelocatable()) {
+        relocations.push_back(it->GetPC());
+      } else if (!expression.IsAbsolute()) {
+        Utils::log_stream << "***** ERROR -- EXPRESSION "
+                          << expression.GetText()
+                          << " CANNOT BE RELOCATED" << endl;
+        this->GetInvalidMessage("EXPRESSION CANNOT BE RELOCATED",
+                                expression.GetText());
+        return false;
+      }
+    } else if (externals_.count(symoperand) != 0) {
+      imports.push_back(make_pair(it->GetPC(), symoperand));
+    } else if (symboltable_.count(symoperand) != 0 &&
+               absolutes_.count(symoperand) == 0) {
+      relocations.push_back(it->GetPC());
+    }
+  }
+
+  int size = machinecode_.size();
+  if (size > 0) {
+    size = machinecode_.rbegin()->first + 1;
+  }
+
+  auto put_word = [&image](int value) {
+    image += static_cast<char>(value & 0xFF);
+    image += static_cast<char>((value >> 8) & 0xFF);
+  };
+
+  image += Globals::kObjectMagic;
+  put_word(Globals::kObjectVersion);
+  put_word(size);
+  put_word(relocations.size());
+  put_word(entries_.size());
+  put_word(imports.size());
+
+  for (int i = 0; i < size; ++i) {
+    auto found = machinecode_.find(i);
+    int value = 0;
+    if (found != machinecode_.end()) {
+      value = globals_.BitStringToDec(found->second);
+    }
+    put_word(value);
+  }
+  for (auto it = relocations.begin(); it != relocations.end(); ++it) {
+    put_word(*it);
+  }
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    image += *it;
+    put_word(symboltable_[*it]);
+  }
+  for (auto it = imports.begin(); it != imports.end(); ++it) {
+    image += it->second;
+    put_word(it->first);
+  }
+  return true;
+}
+
+/******************************************************************************
+ * Mutator 'Reset'.
+ * Clear everything left over from an earlier assembly so that one
+ * 'Assembler' can be used for many sources. The table of valid mnemonics
+ * is kept, since it never changes.
+**/
+void Assembler::Reset() {
+  found_end_statement_ = false;
+  has_an_error_ = false;
+  uses_includes_ = false;
+  pc_in_assembler_ = 0;
+  maxpc_ = 0;
+  codelines_.clear();
+  machinecode_.clear();
+  symboltable_.clear();
+  symbol_vector_.clear();
+  externals_.clear();
+  entries_.clear();
+  equates_.clear();
+  absolutes_.clear();
+  literals_.clear();
+  pending_literals_.clear();
+  image_.clear();
+  fixups_.clear();
+  symbol_ids_.clear();
+  line_hashes_.clear();
+  report_.Clear();
+}
+
+/******************************************************************************
+ * Mutator 'SetReport'.
+ * Turn on the timing of each phase for 'WriteReport'.
+**/
+void Assembler::SetReport(bool is_enabled) {
+  report_.SetEnabled(is_enabled);
+}
+
+/******************************************************************************
+ * Mutator 'SetIncremental'.
+ * Turn on incremental assembly against the given sidecar file. The
+ * sidecar holds the line hashes, symbol table, and machine code of the
+ * last clean assembly, and is rewritten after each clean assembly.
+**/
+void Assembler::SetIncremental(string sidecar_filename) {
+  sidecar_filename_ = sidecar_filename;
+}
+
+/******************************************************************************
+ * Accessor 'UsesIncludes'.
+ * True if the last source read an 'INC' file. The listing and the code
+ * then depend on more than the text of the source.
+**/
+bool Assembler::UsesIncludes() const {
+  return uses_includes_;
+}
+
 /******************************************************************************
  * General functions.
 **/
 
+/******************************************************************************
+ * Function 'AddLiteral'.
+ * Record a literal operand for the literal pool. Literals are merged on
+ * their sixteen-bit value, so '=+FFFF' and '=-0001' share one word, and
+ * a value already placed in an earlier pool is not placed again.
+ *
+ * Parameters:
+ *   hex - the value of the literal
+ *
+ * Returns:
+ *   the name under which the pool word goes in the symbol table
+**/
+string Assembler::AddLiteral(const Hex& hex) {
+  int value = hex.GetValue();
+  auto found = literals_.find(value);
+  if (found != literals_.end()) {
+    return found->second;
+  }
+
+  static const string kHexDigits = "0123456789ABCDEF";
+  int magnitude = (value < 32768) ? value : 65536 - value;
+  string name = (value < 32768) ? "=+" : "=-";
+  for (int shift = 12; shift >= 0; shift -= 4) {
+    name += kHexDigits.at((magnitude >> shift) & 0xF);
+  }
+
+  literals_[value] = name;
+  pending_literals_.push_back(value);
+  return name;
+}
+
 /******************************************************************************
  * Function 'Assemble'.
  * This top level function assembles the code.
  *
  * Parameters:
  *   in_scanner - the scanner to read for source code
+ *   binary_filename - the name of the binary file to write, or "" for
+ *                     none, when the caller takes 'GetBinaryImage'
  *   out_stream - the output stream to write to
 **/
-void Assembler::Assemble(Scanner& in_scanner, string binary_filename, ofstream& out_stream) {
+void Assembler::Assemble(Scanner& in_scanner, string binary_filename, ostream& out_stream) {
 #ifdef EBUG
   Utils::log_stream << "enter Assemble\n"; 
 #endif
 
+  int assemble_phase = report_.Begin("Assemble");
+
   //Create table of valid mnemonics using a set.
-  this->ValidMnemonics();
+  if (mnemonics_.empty()) {
+    int phase = report_.Begin("ValidMnemonics");
+    this->ValidMnemonics();
+    report_.End(phase, 0, 0, 0);
+  }
 
   ////////////////////////////////////////////////////////////////////////////
   // Pass one
@@ -53,7 +298,15 @@ void Assembler::Assemble(Scanner& in_scanner, string binary_filename, ofstream&
   Utils::log_stream << endl << endl << "PASS ONE" << endl;
   out_stream << "PASS ONE\n" << endl;
   cout << "PASS ONE" << endl;
+  int pass_one_phase = report_.Begin("PassOne");
   this->PassOne(in_scanner, out_stream); 
+  report_.End(pass_one_phase, codelines_.size(), 0, 0);
+
+  ////////////////////////////////////////////////////////////////////////////
+  // Fold the equates and expression operands now the symbol table is final.
+  int fold_phase = report_.Begin("FoldExpressions");
+  this->FoldExpressions();
+  report_.End(fold_phase, codelines_.size(), 0, 0);
 
   ////////////////////////////////////////////////////////////////////////////
   // Pass two
@@ -61,7 +314,14 @@ void Assembler::Assemble(Scanner& in_scanner, string binary_filename, ofstream&
   Utils::log_stream << endl << endl << "PASS TWO" << endl;
   out_stream << "PASS TWO\n" << endl;
   cout << "PASS TWO" << endl;
-  this->PassTwo();
+  int pass_two_phase = report_.Begin("PassTwo");
+  if (sidecar_filename_ == "" || !this->PassTwoIncremental()) {
+    this->PassTwo();
+  }
+  report_.End(pass_two_phase, codelines_.size(), machinecode_.size(), 0);
+  if (sidecar_filename_ != "") {
+    this->WriteSidecar();
+  }
 
   ////////////////////////////////////////////////////////////////////////////
   // Dump the results.
@@ -69,11 +329,300 @@ void Assembler::Assemble(Scanner& in_scanner, string binary_filename, ofstream&
   this->PrintSymbolTable(out_stream);
   this->PrintMachineCode(binary_filename, out_stream);
 
+  report_.End(assemble_phase, codelines_.size(), machinecode_.size(), 0);
+
 #ifdef EBUG
   Utils::log_stream << "leave Assemble\n"; 
 #endif
 }
 
+/******************************************************************************
+ * Function 'AssembleStreaming'.
+ * Assemble in one pass, encoding each line as it is read, so that memory
+ * does not grow with the length of the source. Only the image of memory,
+ * the symbol table, the literals, and a list of fixups are kept; each
+ * line is listed and then dropped.
+ *
+ * A Format I instruction whose symbol is not yet defined is encoded with
+ * an address of zero and a fixup (address, symbol id, indirect flag),
+ * which is patched when the symbol is defined. Fixups still open at the
+ * end name undefined or imported symbols and keep the zero, as in the
+ * two pass assembly. Equates and expressions must name only symbols
+ * already defined. Object and sidecar files are not written.
+ *
+ * Parameters:
+ *   in_scanner - the scanner to read for source code
+ *   binary_filename - the name of the binary file to write, or "" for
+ *                     none
+ *   out_stream - the output stream to write to
+**/
+void Assembler::AssembleStreaming(Scanner& in_scanner, string binary_filename,
+                                  ostream& out_stream) {
+#ifdef EBUG
+  Utils::log_stream << "enter AssembleStreaming\n"; 
+#endif
+
+  int assemble_phase = report_.Begin("AssembleStreaming");
+
+  if (mnemonics_.empty()) {
+    int phase = report_.Begin("ValidMnemonics");
+    this->ValidMnemonics();
+    report_.End(phase, 0, 0, 0);
+  }
+
+  Utils::log_stream << endl << endl << "STREAMING PASS" << endl;
+  out_stream << "STREAMING PASS\n" << endl;
+  cout << "STREAMING PASS" << endl;
+  int pass_phase = report_.Begin("StreamingPass");
+
+  int linecounter = 0;
+  pc_in_assembler_ = 0;
+  has_an_error_ = false;
+  image_.assign(Globals::kMaxMemory, -1);
+
+  //Each line, with any literal pool it places, goes through 'codelines_'
+  //and is encoded and listed before the next line is read.
+  Preprocessor source(in_scanner, mnemonics_);
+  string line = source.NextLine();
+  while (line.length() > 0) {
+    line.resize(80, ' ');
+    if (line.substr(0, 1) != "*") {
+      bool is_encoding = !found_end_statement_;
+      this->ReadCodeLine(line, linecounter);
+      for (auto it = codelines_.begin(); it != codelines_.end(); ++it) {
+        this->StreamCodeLine(*it, is_encoding, out_stream);
+      }
+      codelines_.clear();
+      equates_.clear();
+      linecounter += 1;
+    }
+    line = source.NextLine();
+  }
+
+  this->PlaceLiterals(linecounter);
+  uses_includes_ = source.UsesIncludes();
+  for (auto it = codelines_.begin(); it != codelines_.end(); ++it) {
+    this->StreamCodeLine(*it, !found_end_statement_, out_stream);
+  }
+  codelines_.clear();
+  maxpc_ = linecounter;
+
+  for (auto it = symbol_ids_.begin(); it != symbol_ids_.end(); ++it) {
+    if (symboltable_.count(it->first) == 0 &&
+        externals_.count(it->first) == 0) {
+      Utils::log_stream << "UNDEFINED SYMBOL " << it->first << endl;
+    }
+  }
+  Utils::log_stream << "STREAMING PASS LEFT " << fixups_.size()
+                    << " FIXUPS OPEN" << endl;
+
+  if (source.HasAnError()) {
+    has_an_error_ = true;
+    vector<string> messages = source.GetErrorMessages();
+    for (auto it = messages.begin(); it != messages.end(); ++it) {
+      cout << *it << endl;
+      out_stream << *it << endl;
+    }
+  }
+  if (!found_end_statement_) {
+    out_stream << "\n***** ERROR -- NO 'END' STATEMENT\n" << endl;
+    has_an_error_ = true;
+  }
+
+  //As in pass two, a program with errors gets no machine code.
+  if (!has_an_error_) {
+    for (int pc = 0; pc < Globals::kMaxMemory; ++pc) {
+      if (image_.at(pc) >= 0) {
+        machinecode_[pc] = globals_.DecToBitString(image_.at(pc), 16);
+      }
+    }
+  }
+  report_.End(pass_phase, linecounter, machinecode_.size(), 0);
+
+  this->PrintSymbolTable(out_stream);
+  this->PrintMachineCode(binary_filename, out_stream);
+
+  report_.End(assemble_phase, linecounter, machinecode_.size(), 0);
+
+#ifdef EBUG
+  Utils::log_stream << "leave AssembleStreaming\n"; 
+#endif
+}
+
+/******************************************************************************
+ * Function 'EncodeInstruction'.
+ * Create the machine code for a line that assembles to exactly one word:
+ * a Format I or Format II instruction, or a 'HEX' constant.
+ *
+ * Parameters:
+ *   codeline - the line of code to encode
+ *   mnemonic - the mnemonic of the line, with 'RD' normalized
+ *
+ * Returns:
+ *   the sixteen-bit code, or the empty string for any other line
+**/
+string Assembler::EncodeInstruction(const CodeLine& codeline, string mnemonic) {
+  string code = "";
+  int opcode = globals_.MnemonicToOpcode(mnemonic);
+  int format_two = globals_.FormatTwoIndex(mnemonic);
+
+  if (opcode >= 0 && codeline.HasExpression()) {
+    code = globals_.DecToBitString(opcode, 3)
+         + (codeline.GetAddr() == "*" ? "1" : "0")
+         + globals_.DecToBitString(codeline.GetExpression().GetValue(), 12);
+  } else if (opcode >= 0) {
+    code = globals_.DecToBitString(opcode, 3)
+         + this->FindAddress(codeline.GetAddr(), codeline.GetSymOperand());
+  } else if (format_two > 0) {
+    code = globals_.DecToBitString(
+             (Globals::kFormatTwoOpcode << 13) + format_two, 16);
+  } else if (mnemonic == "HEX" && codeline.HasExpression()) {
+    int value = codeline.GetExpression().GetValue();
+    code = globals_.DecToBitString((value + 65536) % 65536, 16);
+  } else if (mnemonic == "HEX") {
+    code = globals_.DecToBitString(codeline.GetHexObject().GetValue(), 16);
+  }
+
+  return code;
+}
+
+/******************************************************************************
+ * Function 'FoldEquate'.
+ * Give one equate its value and enter it in the symbol table.
+ *
+ * Parameters:
+ *   label - the label of the equate
+ *   codeline - the 'EQU' line, which takes any error message
+ *
+ * Returns:
+ *   true if every symbol it names was defined
+**/
+bool Assembler::FoldEquate(string label, CodeLine& codeline) {
+  Expression expression = this->OperandExpression(codeline);
+  if (!expression.Evaluate(symboltable_, absolutes_)) {
+    codeline.SetErrorMessages(codeline.GetErrorMessages()
+                              + expression.GetErrorMessages());
+    has_an_error_ = true;
+    return false;
+  }
+
+  symboltable_[label] = expression.GetValue();
+  if (!expression.IsRelocatable()) {
+    absolutes_.insert(label);
+  }
+  symbol_vector_.push_back("SYM " + label + " "
+                           + Utils::Format(expression.GetValue()) + " ");
+  this->PatchFixups(label, expression.GetValue());
+  return true;
+}
+
+/******************************************************************************
+ * Function 'FoldExpression'.
+ * Give the expression operand of one line its value and check that the
+ * value suits the mnemonic.
+ *
+ * Parameters:
+ *   codeline - the line, which takes the value and any error message
+**/
+void Assembler::FoldExpression(CodeLine& codeline) {
+  Expression expression = codeline.GetExpression();
+  string messages = "";
+  if (!expression.Evaluate(symboltable_, absolutes_)) {
+    messages = expression.GetErrorMessages();
+  } else {
+    string mnemonic = codeline.GetMnemonic();
+    int value = expression.GetValue();
+    int low = 0;
+    int high = Globals::kMaxMemory - 1;
+    if (mnemonic == "HEX") {
+      low = -32768;
+      high = 65535;
+    } else if (mnemonic == "DS " || mnemonic == "ORG") {
+      high = Globals::kMaxMemory;
+    }
+    if (value < low || value > high) {
+      messages = "\n***** ERROR -- EXPRESSION " + expression.GetText()
+               + " IS OUT OF RANGE";
+    }
+  }
+
+  codeline.SetExpression(expression);
+  if (messages != "") {
+    codeline.SetErrorMessages(codeline.GetErrorMessages() + messages);
+    has_an_error_ = true;
+  }
+}
+
+/******************************************************************************
+ * Function 'FoldExpressions'.
+ * Give each equate and each expression operand its value, once pass one
+ * has put every label in the symbol table.
+ *
+ * An equate may name other equates, defined before or after it, so the
+ * equates are folded in topological order of the equates they name. An
+ * equate that is still waiting when none are ready depends on itself.
+ * The expression operands are then evaluated against the full table.
+**/
+void Assembler::FoldExpressions() {
+#ifdef EBUG
+  Utils::log_stream << "enter FoldExpressions\n";
+#endif
+
+  map<string, int> waiting;
+  map<string, vector<string> > dependents;
+  vector<string> ready;
+  for (auto it = equates_.begin(); it != equates_.end(); ++it) {
+    vector<string> symbols =
+        this->OperandExpression(codelines_.at(it->second)).GetSymbols();
+    set<string> needs;
+    for (auto sym = symbols.begin(); sym != symbols.end(); ++sym) {
+      if (equates_.count(*sym) != 0) {
+        needs.insert(*sym);
+      }
+    }
+    for (auto need = needs.begin(); need != needs.end(); ++need) {
+      dependents[*need].push_back(it->first);
+    }
+    waiting[it->first] = needs.size();
+    if (needs.empty()) {
+      ready.push_back(it->first);
+    }
+  }
+
+  while (!ready.empty()) {
+    string label = ready.back();
+    ready.pop_back();
+    this->FoldEquate(label, codelines_.at(equates_[label]));
+
+    vector<string>& after = dependents[label];
+    for (auto it = after.begin(); it != after.end(); ++it) {
+      if (--waiting[*it] == 0) {
+        ready.push_back(*it);
+      }
+    }
+  }
+
+  for (auto it = waiting.begin(); it != waiting.end(); ++it) {
+    if (it->second > 0) {
+      CodeLine& codeline = codelines_.at(equates_[it->first]);
+      codeline.SetErrorMessages(codeline.GetErrorMessages()
+                                + "\n***** ERROR -- EQU " + it->first
+                                + " DEPENDS ON ITSELF");
+      has_an_error_ = true;
+    }
+  }
+
+  for (auto it = codelines_.begin(); it != codelines_.end(); ++it) {
+    if (it->HasExpression() && it->GetMnemonic() != "EQU") {
+      this->FoldExpression(*it);
+    }
+  }
+
+#ifdef EBUG
+  Utils::log_stream << "leave FoldExpressions\n";
+#endif
+}
+
 /******************************************************************************
  * Function 'GetInvalidMessage'.
  * This creates a "value is invalid" error message.
@@ -120,6 +669,112 @@ string Assembler::GetUndefinedMessage(string badtext) {
   return returnvalue;
 }
 
+/******************************************************************************
+ * Function 'OperandExpression'.
+ * The operand of an 'EQU' as an expression. A plain symbolic or hex
+ * operand is read as an expression of just that symbol or number.
+ *
+ * Parameters:
+ *   codeline - the 'EQU' line
+**/
+Expression Assembler::OperandExpression(const CodeLine& codeline) const {
+  if (codeline.HasExpression()) {
+    return codeline.GetExpression();
+  }
+  if (codeline.HasSymOperand()) {
+    string symoperand = codeline.GetSymOperand();
+    return Expression(symoperand.substr(0, symoperand.find(' ')));
+  }
+
+  Hex hex = codeline.GetHexObject();
+  if (hex.IsNull() || hex.HasAnError()) {
+    return Expression(hex.GetText());
+  }
+  int value = hex.GetValue();
+  if (hex.IsNegative()) {
+    value -= 65536;
+  }
+  return Expression(Utils::Format(value));
+}
+
+/******************************************************************************
+ * Function 'ParseCodeLine'.
+ * Break one source line into its fields. Literals go into the pending
+ * literal pool and expression operands are parsed, but nothing else is
+ * recorded.
+ *
+ * Parameters:
+ *   line - the source line, padded to 80 columns
+ *   linecounter - the line counter for this line
+**/
+CodeLine Assembler::ParseCodeLine(const string& line, int linecounter) {
+  CodeLine code_line;
+
+  //Break the line down into substrings.
+  string label = line.substr(0, 3);
+  if (label == "   ") {
+    label = "nulllabel";
+  }
+  string mnemonic = line.substr(4, 3);
+  if (mnemonic == "   ") {
+    mnemonic = "nullmnemonic";
+  }
+  string addr = line.substr(8, 1);
+  if (line.substr(4, 5) == "LTORG") {
+    mnemonic = "LTORG";
+    addr = " ";
+  }
+  string symoperand = line.substr(10, 3);
+  if (symoperand == "   ") {
+    symoperand = "nullsymoperand";
+  }
+  string hexoperand = line.substr(14, 5);
+  string comments = line.substr(20);
+  string code = "nullcode";
+
+  //A literal such as '=+0001' in columns 10-15 of an instruction names
+  //a word in the literal pool.
+  bool is_literal = line.substr(10, 1) == "=" &&
+                    globals_.MnemonicToOpcode(mnemonic) >= 0;
+  string literal_messages = "";
+  if (is_literal) {
+    Hex literal(line.substr(11, 5), globals_);
+    symoperand = line.substr(10, 6);
+    if (literal.HasAnError() || line.substr(16, 3) != "   ") {
+      literal_messages = "\n***** ERROR -- LITERAL " + symoperand
+                       + " IS INVALID";
+      has_an_error_ = true;
+    } else {
+      symoperand = this->AddLiteral(literal);
+    }
+    hexoperand = "     ";
+  }
+
+  //An expression takes the place of both operands. A lone symbol in
+  //either field of a pseudo-op that takes a number is one too.
+  bool is_expression = !is_literal &&
+                       Expression::IsExpression(line.substr(10, 9));
+  if (mnemonic == "HEX" || mnemonic == "DS " || mnemonic == "ORG") {
+    is_expression = is_expression || symoperand != "nullsymoperand" ||
+                    isalpha(hexoperand.at(0));
+  }
+  if (is_expression) {
+    symoperand = "nullsymoperand";
+    hexoperand = "     ";
+  }
+
+  code_line.SetCodeLine(linecounter, pc_in_assembler_, label, mnemonic,
+                        addr, symoperand, hexoperand, comments, code);
+  code_line.SetErrorMessages(literal_messages);
+  if (is_expression) {
+    string text = line.substr(10, 9);
+    text = text.substr(text.find_first_not_of(' '));
+    code_line.SetExpression(Expression(text.substr(0, text.find(' '))));
+  }
+
+  return code_line;
+}
+
 /******************************************************************************
  * Function 'PassOne'.
  * Produce the symbol table and detect multiply defined symbols.
@@ -133,7 +788,7 @@ string Assembler::GetUndefinedMessage(string badtext) {
  *   in_scanner - the input stream from which to read
  *   out-stream - the output stream to which to write
 **/
-void Assembler::PassOne(Scanner& in_scanner, ofstream& out_stream) {
+void Assembler::PassOne(Scanner& in_scanner, ostream& out_stream) {
 #ifdef EBUG
   Utils::log_stream << "enter PassOne\n"; 
 #endif
@@ -142,56 +797,39 @@ void Assembler::PassOne(Scanner& in_scanner, ofstream& out_stream) {
   pc_in_assembler_ = 0;
   has_an_error_ = false;
 
+  //Macros and include files are expanded as the lines are read.
+  Preprocessor source(in_scanner, mnemonics_);
+
   //Read one line at a time.
-  string line = in_scanner.NextLine();
+  string line = source.NextLine();
   while (line.length() > 0) {
        
-  line.resize(80);
+  line.resize(80, ' ');
 
   //Create instance of Codeline
   CodeLine code_line;
   while (line.substr(0, 1) == "*") {
     code_line.SetCommentsOnly(linecounter, line);
-    line = in_scanner.NextLine();
-    line.resize(80);
+    line = source.NextLine();
+    line.resize(80, ' ');
   } 
 
-  //Break the line down into substrings.
-  string label = line.substr(0, 3);
-  if (label == "   ") {
-    label = "nulllabel";
-  }
-  string mnemonic = line.substr(4, 3);
-  if (mnemonic == "   ") {
-    mnemonic = "nullmnemonic";
-  }
-  string addr = line.substr(8, 1);
-  string symoperand = line.substr(10, 3);
-  if (symoperand == "   ") {
-    symoperand = "nullsymoperand";
-  }
-  string hexoperand = line.substr(14, 5);
-  string comments = line.substr(20);
-  string code = "nullcode";
-
-  code_line.SetCodeLine(linecounter, pc_in_assembler_, label, mnemonic,
-                        addr, symoperand, hexoperand, comments, code);
-  codelines_.push_back(code_line);
-      
-  //Update Symbol Table
-  if (label != "nulllabel") {
-    this->UpdateSymbolTable(pc_in_assembler_, label);
-  }
+  this->ReadCodeLine(line, linecounter);
 
-  //Check for END Statement
-  if (mnemonic == "END") {
-    found_end_statement_ = true;
-  }
-    
   //Increment and retrieve next line
   linecounter += 1;
-  pc_in_assembler_ += 1;
-  line = in_scanner.NextLine();
+  line = source.NextLine();
+  }
+  this->PlaceLiterals(linecounter);
+  uses_includes_ = source.UsesIncludes();
+
+  if (source.HasAnError()) {
+    has_an_error_ = true;
+    vector<string> messages = source.GetErrorMessages();
+    for (auto it = messages.begin(); it != messages.end(); ++it) {
+      cout << *it << endl;
+      out_stream << *it << endl;
+    }
   }
 
   //Print Codelines
@@ -234,39 +872,17 @@ void Assembler::PassTwo() {
     string mnemonic = codeline.GetMnemonic();
     Hex hex = codeline.GetHexObject();
     int hex_dec = hex.GetValue();
+    if (codeline.HasExpression()) {
+      hex_dec = codeline.GetExpression().GetValue();
+    }
     string code = "";
 
-    string addr = codeline.GetAddr();
-    string symoperand = codeline.GetSymOperand();
-    string full_address = this->FindAddress(addr, symoperand);    
-
     if (mnemonic.find("RD") != std::string::npos) {
       mnemonic = "RD ";
     }
 
     if (mnemonics_.count(mnemonic) != 0) { 
-      
-      if (mnemonic == "BAN") {
-        code += "000" + full_address;
-      } else if (mnemonic == "SUB") {
-        code += "001" + full_address;
-      } else if (mnemonic == "STC") {
-        code += "010" + full_address;
-      } else if (mnemonic == "AND") {
-        code += "011" + full_address;
-      } else if (mnemonic == "ADD") {
-        code += "100" + full_address;
-      } else if (mnemonic == "LD ") {
-        code += "101" + full_address;
-      } else if (mnemonic == "BR ") {
-        code += "110" + full_address;
-      } else if(mnemonic == "RD ") {
-        code = "1110000000000001";
-      } else if (mnemonic == "STP") {
-        code = "1110000000000010";
-      } else if (mnemonic == "WRT") {
-        code = "1110000000000011";
-      } else if (mnemonic == "ORG") {
+      if (mnemonic == "ORG") {
         set_machine_code = false;
         pc_in_assembler_ = hex_dec - 1;
       } else if (mnemonic == "DS ") {
@@ -277,8 +893,11 @@ void Assembler::PassTwo() {
       } else if (mnemonic == "END") {
         set_machine_code = false;
         break;
-      } else if (mnemonic == "HEX") {
-        code = globals_.DecToBitString(hex_dec, 16);
+      } else if (mnemonic == "ENT" || mnemonic == "EXT" ||
+                 mnemonic == "EQU" || mnemonic == "LTORG") {
+        set_machine_code = false;
+      } else {
+        code = this->EncodeInstruction(codeline, mnemonic);
       }
     } else {
       this->GetInvalidMessage("INVALID MNEMONIC", mnemonic); 
@@ -297,14 +916,222 @@ void Assembler::PassTwo() {
 #endif
 }
 
+/******************************************************************************
+ * Function 'PassTwoIncremental'.
+ * Pass two against the sidecar from the last clean assembly. When no PC
+ * has moved, the old machine code is kept and only lines whose text has
+ * changed, or whose symbolic operand has changed location, are encoded
+ * again. Any change to a line that is not a single word of code (ORG,
+ * DS, END, linkage) other than an equate falls back to a full pass two.
+ *
+ * Returns:
+ *   true if the machine code was produced incrementally
+**/
+bool Assembler::PassTwoIncremental() {
+#ifdef EBUG
+  Utils::log_stream << "enter PassTwoIncremental\n"; 
+#endif
+
+  if (has_an_error_ || !found_end_statement_) {
+    return false;
+  }
+
+  ifstream in_stream(sidecar_filename_.c_str(), ios::binary);
+  if (in_stream.fail()) {
+    return false;
+  }
+  string sidecar((istreambuf_iterator<char>(in_stream)),
+                 istreambuf_iterator<char>());
+
+  size_t offset = kSidecarMagic.length();
+  string version = "";
+  uint64_t how_many = 0;
+  if (sidecar.compare(0, offset, kSidecarMagic) != 0 ||
+      !GetString(sidecar, offset, version) ||
+      version != Globals::kAssemblerVersion ||
+      !GetValue(sidecar, offset, how_many) ||
+      how_many != codelines_.size()) {
+    return false;
+  }
+
+  //Any line whose PC has moved means a full pass.
+  vector<uint64_t> old_hashes(how_many);
+  vector<string> old_mnemonics(how_many);
+  for (uint64_t i = 0; i < how_many; ++i) {
+    uint64_t pc = 0;
+    if (!GetValue(sidecar, offset, old_hashes[i]) ||
+        !GetValue(sidecar, offset, pc) ||
+        !GetString(sidecar, offset, old_mnemonics[i]) ||
+        static_cast<int>(pc) != codelines_.at(i).GetPC()) {
+      return false;
+    }
+  }
+
+  //A symbol has changed if it was added, removed, or moved.
+  set<string> changed_symbols;
+  map<string, int> old_symboltable;
+  if (!GetValue(sidecar, offset, how_many)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < how_many; ++i) {
+    string symbol = "";
+    uint64_t location = 0;
+    if (!GetString(sidecar, offset, symbol) ||
+        !GetValue(sidecar, offset, location)) {
+      return false;
+    }
+    old_symboltable[symbol] = location;
+    auto found = symboltable_.find(symbol);
+    if (found == symboltable_.end() ||
+        found->second != static_cast<int>(location)) {
+      changed_symbols.insert(symbol);
+    }
+  }
+  for (auto it = symboltable_.begin(); it != symboltable_.end(); ++it) {
+    if (old_symboltable.count(it->first) == 0) {
+      changed_symbols.insert(it->first);
+    }
+  }
+
+  map<int, string> machinecode;
+  if (!GetValue(sidecar, offset, how_many)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < how_many; ++i) {
+    uint64_t pc = 0;
+    string code = "";
+    if (!GetValue(sidecar, offset, pc) || !GetString(sidecar, offset, code)) {
+      return false;
+    }
+    machinecode[pc] = code;
+  }
+
+  int reencoded = 0;
+  for (size_t i = 0; i < codelines_.size(); ++i) {
+    const CodeLine& codeline = codelines_.at(i);
+    string mnemonic = codeline.GetMnemonic();
+    if (mnemonic.find("RD") != std::string::npos) {
+      mnemonic = "RD ";
+    }
+
+    bool is_changed = line_hashes_.at(i) != old_hashes.at(i) ||
+                      changed_symbols.count(codeline.GetSymOperand()) != 0;
+    if (codeline.HasExpression()) {
+      vector<string> symbols = codeline.GetExpression().GetSymbols();
+      for (auto it = symbols.begin(); it != symbols.end(); ++it) {
+        is_changed = is_changed || changed_symbols.count(*it) != 0;
+      }
+    }
+
+    if (!is_changed) {
+      if (mnemonic == "END") {
+        break;
+      }
+      continue;
+    }
+
+    //A changed equate has no code of its own; the lines that use it
+    //see it as a changed symbol.
+    string old_mnemonic = old_mnemonics.at(i);
+    if (mnemonic == "EQU" && old_mnemonic == "EQU") {
+      continue;
+    }
+
+    string code = "";
+    if (mnemonics_.count(mnemonic) != 0) {
+      code = this->EncodeInstruction(codeline, mnemonic);
+    }
+    if (code == "" || (old_mnemonic != "HEX" &&
+                       globals_.MnemonicToOpcode(old_mnemonic) < 0 &&
+                       globals_.FormatTwoIndex(old_mnemonic) <= 0)) {
+      return false;
+    }
+    machinecode[codeline.GetPC()] = code;
+    ++reencoded;
+  }
+
+  machinecode_ = machinecode;
+  Utils::log_stream << "INCREMENTAL PASS TWO ENCODED " << reencoded
+                    << " OF " << codelines_.size() << " LINES" << endl;
+
+#ifdef EBUG
+  Utils::log_stream << "leave PassTwoIncremental\n"; 
+#endif
+  return true;
+}
+
+/******************************************************************************
+ * Function 'PatchFixups'.
+ * Fill in the address of each streamed instruction that was waiting for
+ * a symbol, now that the symbol is defined.
+ *
+ * Parameters:
+ *   symbol - the symbol just defined
+ *   location - its value
+**/
+void Assembler::PatchFixups(string symbol, int location) {
+  auto found = symbol_ids_.find(symbol);
+  if (fixups_.empty() || found == symbol_ids_.end()) {
+    return;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < fixups_.size(); ++i) {
+    const Fixup& fixup = fixups_.at(i);
+    if (fixup.symbol != found->second) {
+      fixups_.at(kept++) = fixup;
+      continue;
+    }
+    int& word = image_.at(fixup.address);
+    word = (word & 0xE000) | (fixup.is_indirect ? 0x1000 : 0)
+         | (location & 0x0FFF);
+  }
+  fixups_.resize(kept);
+}
+
+/******************************************************************************
+ * Function 'PlaceLiterals'.
+ * Place the literals used since the last pool as 'HEX' lines at the
+ * current PC. This is done at each 'LTORG' and just before 'END'.
+ *
+ * Parameters:
+ *   linecounter - the source line that places the pool
+**/
+void Assembler::PlaceLiterals(int linecounter) {
+#ifdef EBUG
+  Utils::log_stream << "enter PlaceLiterals\n";
+#endif
+
+  for (auto it = pending_literals_.begin(); it != pending_literals_.end();
+       ++it) {
+    string name = literals_[*it];
+    CodeLine code_line;
+    code_line.SetCodeLine(linecounter, pc_in_assembler_, "nulllabel", "HEX",
+                          " ", "nullsymoperand", name.substr(1),
+                          "* literal pool", "nullcode");
+    codelines_.push_back(code_line);
+    if (sidecar_filename_ != "") {
+      line_hashes_.push_back(globals_.HashBytes(name));
+    }
+    this->UpdateSymbolTable(pc_in_assembler_, name);
+    pc_in_assembler_ += 1;
+  }
+  pending_literals_.clear();
+
+#ifdef EBUG
+  Utils::log_stream << "leave PlaceLiterals\n";
+#endif
+}
+
 /******************************************************************************
  * Function 'PrintCodeLines'.
  * This function prints the code lines.
 **/
-void Assembler::PrintCodeLines(ofstream& out_stream) {
+void Assembler::PrintCodeLines(ostream& out_stream) {
 #ifdef EBUG
   Utils::log_stream << "enter PrintCodeLines\n"; 
 #endif
+  int phase = report_.Begin("PrintCodeLines");
   string s = "";
 
   for (auto iter = codelines_.begin(); iter != codelines_.end(); ++iter) {
@@ -319,6 +1146,7 @@ void Assembler::PrintCodeLines(ofstream& out_stream) {
   cout << s << endl;
   out_stream << s << endl;
   Utils::log_stream << s << endl;
+  report_.End(phase, codelines_.size(), 0, s.length() + 1);
 
 #ifdef EBUG
   Utils::log_stream << "leave PrintCodeLines\n"; 
@@ -329,9 +1157,10 @@ void Assembler::PrintCodeLines(ofstream& out_stream) {
  * Function 'PrintMachineCode'.
  * This function prints the machine code.
 **/
-void Assembler::PrintMachineCode(string binary_filename, ofstream& out_stream) {
+void Assembler::PrintMachineCode(string binary_filename, ostream& out_stream) {
 #ifdef EBUG
 #endif
+  int phase = report_.Begin("PrintMachineCode");
   string s = "MACHINE CODE \n";
 
   Utils::log_stream << "enter PrintMachineCode" << " "
@@ -346,7 +1175,10 @@ void Assembler::PrintMachineCode(string binary_filename, ofstream& out_stream) {
   out_stream << s << endl;
   Utils::log_stream << s << endl;
 
-  this->WriteBinaryFile(binary_filename);
+  if (binary_filename != "") {
+    this->WriteBinaryFile(binary_filename);
+  }
+  report_.End(phase, 0, machinecode_.size(), s.length() + 1);
 
 #ifdef EBUG
   Utils::log_stream << "leave PrintMachineCode" << endl; 
@@ -357,10 +1189,11 @@ void Assembler::PrintMachineCode(string binary_filename, ofstream& out_stream) {
  * Function 'PrintSymbolTable'.
  * This function prints the symbol table.
 **/
-void Assembler::PrintSymbolTable(ofstream& out_stream) {
+void Assembler::PrintSymbolTable(ostream& out_stream) {
 #ifdef EBUG
   Utils::log_stream << "enter PrintSymbolTable\n"; 
 #endif
+  int phase = report_.Begin("PrintSymbolTable");
   string s = "\n SYMBOL TABLE\n    SYM LOC FLAGS\n";
 
   for (int i = 0; i < symbol_vector_.size(); ++i) {
@@ -370,13 +1203,73 @@ void Assembler::PrintSymbolTable(ofstream& out_stream) {
   cout << s << endl;
   out_stream << s << endl;
   Utils::log_stream << s << endl;
-
+  report_.End(phase, symbol_vector_.size(), 0, s.length() + 1);
 
 #ifdef EBUG
   Utils::log_stream << "leave PrintSymbolTable\n"; 
 #endif
 }
 
+/******************************************************************************
+ * Function 'ReadCodeLine'.
+ * Record one source line for pass one: add it, and any literal pool it
+ * places, to 'codelines_', enter its label in the symbol table, note the
+ * linkage statements, and advance the PC.
+ *
+ * Parameters:
+ *   line - the source line, padded to 80 columns
+ *   linecounter - the line counter for this line
+**/
+void Assembler::ReadCodeLine(const string& line, int linecounter) {
+  //The literal pool goes just ahead of the 'END'.
+  if (line.substr(4, 3) == "END") {
+    this->PlaceLiterals(linecounter);
+  }
+
+  CodeLine code_line = this->ParseCodeLine(line, linecounter);
+  string label = code_line.GetLabel();
+  string mnemonic = code_line.GetMnemonic();
+  string symoperand = code_line.GetSymOperand();
+
+  codelines_.push_back(code_line);
+  if (sidecar_filename_ != "") {
+    line_hashes_.push_back(globals_.HashBytes(line));
+  }
+      
+  //Update Symbol Table
+  //Equates get their values once the table is final.
+  if (label != "nulllabel" && mnemonic == "EQU") {
+    if (symboltable_.count(label) == 0 && equates_.count(label) == 0) {
+      equates_[label] = codelines_.size() - 1;
+    } else {
+      symbol_vector_.push_back("SYM " + label + " EQU "
+          + this->GetInvalidMessage("SYMBOL ALREADY USED", label));
+    }
+  } else if (label != "nulllabel") {
+    this->UpdateSymbolTable(pc_in_assembler_, label);
+  }
+
+  //Check for END Statement
+  if (mnemonic == "END") {
+    found_end_statement_ = true;
+  } else if (mnemonic == "LTORG") {
+    this->PlaceLiterals(linecounter);
+  }
+
+  //Record the linkage of imported and exported symbols
+  if (mnemonic == "EXT" && symoperand != "nullsymoperand") {
+    externals_.insert(symoperand);
+  } else if (mnemonic == "ENT" && symoperand != "nullsymoperand") {
+    entries_.push_back(symoperand);
+  }
+
+  //The linkage statements, equates, and 'LTORG' take no memory.
+  if (mnemonic != "EXT" && mnemonic != "ENT" && mnemonic != "EQU" &&
+      mnemonic != "LTORG") {
+    pc_in_assembler_ += 1;
+  }
+}
+
 /******************************************************************************
  * Function 'SetNewPC'.
  * This function gets a new value for the program counter.
@@ -398,6 +1291,72 @@ void Assembler::SetNewPC(CodeLine codeline) {
 #endif
 }
 
+/******************************************************************************
+ * Function 'StreamCodeLine'.
+ * Encode one line into the image for a streaming assembly, then list it.
+ * This mirrors 'PassTwo', but with fixups for forward references.
+ *
+ * Parameters:
+ *   codeline - the line, which takes any error message
+ *   is_encoding - false for lines after the 'END'
+ *   out_stream - the output stream to list the line to
+**/
+void Assembler::StreamCodeLine(CodeLine& codeline, bool is_encoding,
+                               ostream& out_stream) {
+  string label = codeline.GetLabel();
+  string mnemonic = codeline.GetMnemonic();
+  if (mnemonic == "EQU" && equates_.count(label) != 0) {
+    this->FoldEquate(label, codeline);
+  } else if (codeline.HasExpression()) {
+    this->FoldExpression(codeline);
+  }
+  if (mnemonic.find("RD") != std::string::npos) {
+    mnemonic = "RD ";
+  }
+
+  int pc = codeline.GetPC();
+  if (!is_encoding) {
+    out_stream << codeline.ToString() << endl;
+    return;
+  }
+
+  if (mnemonics_.count(mnemonic) == 0) {
+    this->GetInvalidMessage("INVALID MNEMONIC", mnemonic);
+    cout << "INVALID MNEMONIC" << endl;
+  } else if (mnemonic == "DS ") {
+    int how_many = codeline.GetHexObject().GetValue();
+    if (codeline.HasExpression()) {
+      how_many = codeline.GetExpression().GetValue();
+    }
+    for (int i = 0; i < how_many && pc + i < Globals::kMaxMemory; ++i) {
+      image_.at(pc + i) = 0xFFFF;
+    }
+  } else if (pc < Globals::kMaxMemory) {
+    string code = this->EncodeInstruction(codeline, mnemonic);
+    if (code != "") {
+      image_.at(pc) = globals_.BitStringToDec(code);
+    }
+
+    string symoperand = codeline.GetSymOperand();
+    if (globals_.MnemonicToOpcode(mnemonic) >= 0 &&
+        !codeline.HasExpression() && codeline.HasSymOperand() &&
+        symboltable_.count(symoperand) == 0 &&
+        externals_.count(symoperand) == 0) {
+      if (symbol_ids_.count(symoperand) == 0) {
+        int id = symbol_ids_.size();
+        symbol_ids_[symoperand] = id;
+      }
+      Fixup fixup;
+      fixup.address = pc;
+      fixup.symbol = symbol_ids_[symoperand];
+      fixup.is_indirect = (codeline.GetAddr() == "*");
+      fixups_.push_back(fixup);
+    }
+  }
+
+  out_stream << codeline.ToString() << endl;
+}
+
 /******************************************************************************
  * Function 'UpdateSymbolTable'.
  * This function updates the symbol table for a putative symbol.
@@ -418,8 +1377,10 @@ void Assembler::UpdateSymbolTable(int pc, string symboltext) {
 
   if (symboltext != "nullsymoperand") {
     s += symboltext + " " + Utils::Format(pc) + " ";
-    if (symboltable_.count(symboltext) == 0) {
+    if (symboltable_.count(symboltext) == 0 &&
+        equates_.count(symboltext) == 0) {
       symboltable_[symboltext] = pc;
+      this->PatchFixups(symboltext, pc);
     } else {
       s += this->GetInvalidMessage("SYMBOL ALREADY USED", symboltext);
     }
@@ -442,24 +1403,26 @@ void Assembler::ValidMnemonics() {
 #endif
 
   //Format I
-  mnemonics_.insert("BAN");
-  mnemonics_.insert("SUB");
-  mnemonics_.insert("STC");
-  mnemonics_.insert("AND");
-  mnemonics_.insert("ADD");
-  mnemonics_.insert("LD ");
-  mnemonics_.insert("BR ");
+  for (int i = 0; i < Globals::kFormatTwoOpcode; ++i) {
+    mnemonics_.insert(Globals::kOpcodeMnemonics[i]);
+  }
 
   //Format II 
-  mnemonics_.insert("RD ");
-  mnemonics_.insert("STP");
-  mnemonics_.insert("WRT");
+  for (int i = 1; i < 4; ++i) {
+    mnemonics_.insert(Globals::kFormatTwoMnemonics[i]);
+  }
 
   //Pseudo-Op Instructions
   mnemonics_.insert("ORG");
   mnemonics_.insert("END");
   mnemonics_.insert("HEX");
   mnemonics_.insert("DS ");
+  mnemonics_.insert("EQU");
+  mnemonics_.insert("LTORG");
+
+  //Linkage Instructions
+  mnemonics_.insert("ENT");
+  mnemonics_.insert("EXT");
 
   //Printing
   Utils::log_stream << "VALID MNEMOICS:\n";
@@ -475,7 +1438,10 @@ void Assembler::ValidMnemonics() {
 
 /******************************************************************************
  * Function 'FindAddress'.
- * Find the address of the function
+ * Find the address field for a Format I instruction: the indirect bit
+ * followed by the twelve-bit location of the symbolic operand. Imported
+ * and undefined symbols give a location of zero; imported ones are
+ * patched by the linker.
  *
  * Parameters:
  *   addr - for indirect addressing
@@ -487,25 +1453,24 @@ string Assembler::FindAddress(string addr, string symoperand) {
 #endif
   
   string ret_string = "0";
-
-  int location = symboltable_[symoperand];
+  int location = 0;
 
   if (addr == "*") {
-    CodeLine indirect = codelines_.at(location);
-    location = symboltable_[indirect.GetSymOperand()];
     ret_string = "1";
   }
-  CodeLine temp = codelines_.at(location);
-  Hex hex = temp.GetHexObject();
-  int hex_dec = hex.GetValue();
 
-  ret_string += globals_.DecToBitString(hex_dec, 12);
-  
-  return ret_string;
+  auto found = symboltable_.find(symoperand);
+  if (found != symboltable_.end()) {
+    location = found->second;
+  }
+
+  ret_string += globals_.DecToBitString(location, 12);
 
 #ifdef EBUG
   Utils::log_stream << "leave FindAddress\n";
 #endif
+  
+  return ret_string;
 }
 
 /******************************************************************************
@@ -518,20 +1483,130 @@ void Assembler::WriteBinaryFile(string binary_filename) {
   Utils::log_stream << "enter WriteBinaryFile\n";
 #endif
 
+  int phase = report_.Begin("WriteBinaryFile");
   FILE *fp = fopen(binary_filename.c_str(), "w");
 
-  int size = machinecode_.size();
+  string image = this->GetBinaryImage();
+  if (fp != NULL) {
+    fwrite(image.data(), 1, image.size(), fp);
+    fclose(fp);
+  }
+  report_.End(phase, 0, image.size() / 2, image.size());
 
-  for (int i = 0; i < size; ++i) {
-    string machine_string = machinecode_[i];
-    int machine_decimal = globals_.BitStringToDec(machine_string);
-    short machine_binary = static_cast<short>(machine_decimal);
-    fwrite(&machine_binary, 2, 1, fp);
+#ifdef EBUG
+  Utils::log_stream << "leave WriteBinaryFile\n";
+#endif
+}
+
+/******************************************************************************
+ * Function 'WriteObjectFile'.
+ * Writes a relocatable object file for the linker. All values are
+ * written as 16-bit little-endian words, in this order:
+ *   the tag 'P16O', the format version,
+ *   the counts of code words, relocations, entries, and imports,
+ *   the code words,
+ *   the address of each word whose address field is module-relative,
+ *   each entry as a three character name and its location,
+ *   each import as a three character name and the referencing address.
+ *
+ * Parameters:
+ *   object_filename - the name of the file to write
+ *
+ * Returns:
+ *   true if the module assembled cleanly and the file was written
+**/
+bool Assembler::WriteObjectFile(string object_filename) {
+#ifdef EBUG
+  Utils::log_stream << "enter WriteObjectFile\n";
+#endif
+
+  string words = "";
+  if (!this->GetObjectImage(words)) {
+    return false;
+  }
+
+  int phase = report_.Begin("WriteObjectFile");
+  FILE *fp = fopen(object_filename.c_str(), "w");
+  if (fp == NULL) {
+    Utils::log_stream << "open failed for '" << object_filename << "'\n";
+    report_.End(phase, 0, 0, 0);
+    return false;
   }
 
+  fwrite(words.data(), 1, words.size(), fp);
   fclose(fp);
+  report_.End(phase, 0, words.size() / 2, words.size());
 
 #ifdef EBUG
-  Utils::log_stream << "leave WriteBinaryFile\n";
+  Utils::log_stream << "leave WriteObjectFile\n";
 #endif
+  return true;
+}
+
+/******************************************************************************
+ * Function 'WriteSidecar'.
+ * Writes the state that 'PassTwoIncremental' needs: for each line its
+ * hash, PC and mnemonic, then the symbol table, then the machine code.
+ * Only a clean assembly is recorded.
+**/
+void Assembler::WriteSidecar() {
+#ifdef EBUG
+  Utils::log_stream << "enter WriteSidecar\n";
+#endif
+
+  if (has_an_error_ || !found_end_statement_) {
+    return;
+  }
+
+  int phase = report_.Begin("WriteSidecar");
+  string sidecar = kSidecarMagic;
+  PutString(sidecar, Globals::kAssemblerVersion);
+
+  PutValue(sidecar, codelines_.size());
+  for (size_t i = 0; i < codelines_.size(); ++i) {
+    string mnemonic = codelines_.at(i).GetMnemonic();
+    if (mnemonic.find("RD") != std::string::npos) {
+      mnemonic = "RD ";
+    }
+    PutValue(sidecar, line_hashes_.at(i));
+    PutValue(sidecar, codelines_.at(i).GetPC());
+    PutString(sidecar, mnemonic);
+  }
+
+  PutValue(sidecar, symboltable_.size());
+  for (auto it = symboltable_.begin(); it != symboltable_.end(); ++it) {
+    PutString(sidecar, it->first);
+    PutValue(sidecar, it->second);
+  }
+
+  PutValue(sidecar, machinecode_.size());
+  for (auto it = machinecode_.begin(); it != machinecode_.end(); ++it) {
+    PutValue(sidecar, it->first);
+    PutString(sidecar, it->second);
+  }
+
+  FILE *fp = fopen(sidecar_filename_.c_str(), "w");
+  if (fp != NULL) {
+    fwrite(sidecar.data(), 1, sidecar.size(), fp);
+    fclose(fp);
+  }
+  report_.End(phase, codelines_.size(), machinecode_.size(), sidecar.size());
+
+#ifdef EBUG
+  Utils::log_stream << "leave WriteSidecar\n";
+#endif
+}
+
+/******************************************************************************
+ * Function 'WriteReport'.
+ * Writes the phase timings recorded since the last 'Reset' as JSON.
+ *
+ * Parameters:
+ *   report_filename - the name of the file to write
+ *
+ * Returns:
+ *   true if the file was written
+**/
+bool Assembler::WriteReport(string report_filename) {
+  return report_.Write(report_filename);
 }
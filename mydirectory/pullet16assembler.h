@@ -11,9 +11,11 @@
 #define ASSEMBLER_H
 
 #include <iostream>
+#include <cstdint>
 #include <set>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 using namespace std;
 
@@ -23,19 +25,41 @@ using namespace std;
 
 #include "globals.h"
 #include "codeline.h"
+#include "expression.h"
 #include "hex.h"
+#include "phasereport.h"
+#include "preprocessor.h"
 #include "symbol.h"
 
 class Assembler {
+  friend class AssemblerBench;
+
   public:
     Assembler();
     virtual ~Assembler();
 
-    void Assemble(Scanner& in_scanner, string binary_filename, ofstream& out_stream);
+    void Assemble(Scanner& in_scanner, string binary_filename, ostream& out_stream);
+    void AssembleStreaming(Scanner& in_scanner, string binary_filename,
+                           ostream& out_stream);
+    string GetBinaryImage();
+    bool GetObjectImage(string& image);
+    void Reset();
+    void SetIncremental(string sidecar_filename);
+    void SetReport(bool is_enabled);
+    bool UsesIncludes() const;
+    bool WriteObjectFile(string object_filename);
+    bool WriteReport(string report_filename);
 
   private:
+    struct Fixup {
+      uint16_t address;
+      uint16_t symbol;
+      bool is_indirect;
+    };
+
     bool found_end_statement_;
     bool has_an_error_;
+    bool uses_includes_;
 
     const string kDummyCodeA = "1100110011001100";
     const string kDummyCodeB= "111100001111";
@@ -51,19 +75,51 @@ class Assembler {
     set<string> mnemonics_;
     vector<string> symbol_vector_;
 
+    set<string> externals_;
+    vector<string> entries_;
+
+    map<string, size_t> equates_;
+    set<string> absolutes_;
+
+    unordered_map<int, string> literals_;
+    vector<int> pending_literals_;
+
+    vector<int> image_;
+    vector<Fixup> fixups_;
+    map<string, int> symbol_ids_;
+
+    string sidecar_filename_;
+    vector<uint64_t> line_hashes_;
+
+    PhaseReport report_;
+
+    string AddLiteral(const Hex& hex);
+    string EncodeInstruction(const CodeLine& codeline, string mnemonic);
+    bool FoldEquate(string label, CodeLine& codeline);
+    void FoldExpression(CodeLine& codeline);
+    void FoldExpressions();
     string GetInvalidMessage(string leadingtext, string invalidstring);
     string GetInvalidMessage(string leadingtext, Hex hex);
     string GetUndefinedMessage(string badtext);
+    Expression OperandExpression(const CodeLine& codeline) const;
+    CodeLine ParseCodeLine(const string& line, int linecounter);
     void PassOne(Scanner& in_scanner);
-    void PassOne(Scanner& in_scanner, ofstream& out_stream);
+    void PassOne(Scanner& in_scanner, ostream& out_stream);
     void PassTwo();
-    void PrintCodeLines(ofstream& out_stream);
-    void PrintMachineCode(string binary_filename, ofstream& out_stream);
-    void PrintSymbolTable(ofstream& out_stream);
+    bool PassTwoIncremental();
+    void PatchFixups(string symbol, int location);
+    void PlaceLiterals(int linecounter);
+    void PrintCodeLines(ostream& out_stream);
+    void PrintMachineCode(string binary_filename, ostream& out_stream);
+    void PrintSymbolTable(ostream& out_stream);
+    void ReadCodeLine(const string& line, int linecounter);
     void SetNewPC(CodeLine codeline);
+    void StreamCodeLine(CodeLine& codeline, bool is_encoding,
+                        ostream& out_stream);
     void UpdateSymbolTable(int pc, string symboltext);
     void ValidMnemonics();
     void WriteBinaryFile(string binary_filename);
+    void WriteSidecar();
     string FindAddress(string addr, string symoperand);
 
     Globals globals_;